@@ -22,11 +22,145 @@
   SOFTWARE.
 */
 
-#include "Arduino.h"
+#include "CST816S.h"
+#include "CST816S_Predictor.h"
+#include "CST816S_Transform.h"
+#include "CST816S_Filter.h"
+#include "CST816S_Recorder.h"
+
+#if CST816S_HAL_ARDUINO
 #include <Wire.h>
-#include <FunctionalInterrupt.h>
+#endif
 
-#include "CST816S.h"
+#if CST816S_FAST_GPIO && CST816S_ESP32
+#include <hal/gpio_ll.h>
+#endif
+
+#if CST816S_ESP32
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <soc/soc_caps.h>
+#endif
+
+#include "CST816S_HAL_Compat.h"
+
+#if CST816S_ESP32
+#define CST816S_RTC_MAGIC 0xC816C816
+
+// Controller state kept in RTC memory across MCU deep sleep (one controller)
+struct cst816s_rtc_state {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t versionInfo[3];
+  uint8_t power_mode;
+  uint8_t config[CST816S_CONFIG_SIZE];
+  uint32_t config_known;
+};
+
+RTC_DATA_ATTR static cst816s_rtc_state rtc_state;
+#endif
+
+#if CST816S_ESP32
+/*!
+    @brief  holds the bus lock for the current scope
+
+    Without the acquisition task there is only one context and the lock is
+    never created. The mutex is recursive, as register operations nest
+    (apply_config() inside set_power_mode(), recovery inside a transfer).
+*/
+class bus_guard {
+  public:
+    explicit bus_guard(SemaphoreHandle_t lock) : _lock(lock)
+    {
+      if (_lock != nullptr)
+        xSemaphoreTakeRecursive(_lock, portMAX_DELAY);
+    }
+    ~bus_guard()
+    {
+      if (_lock != nullptr)
+        xSemaphoreGiveRecursive(_lock);
+    }
+
+  private:
+    SemaphoreHandle_t _lock;
+};
+#define BUS_GUARD() bus_guard guard(_bus_lock)
+#else
+#define BUS_GUARD()
+#endif
+
+/*!
+    @brief  drive an output pin, using direct register access with CST816S_FAST_GPIO
+*/
+static inline void IRAM_ATTR pin_write(int pin, uint8_t level)
+{
+#if CST816S_FAST_GPIO && CST816S_ESP32
+  gpio_ll_set_level(&GPIO, static_cast<gpio_num_t>(pin), level);
+#elif CST816S_FAST_GPIO && defined(ESP8266)
+  if (pin < 16)
+  {
+    if (level)
+      GPOS = 1 << pin;
+    else
+      GPOC = 1 << pin;
+    return;
+  }
+  cst816s_digital_write(pin, level);
+#else
+  cst816s_digital_write(pin, level);
+#endif
+}
+
+/*!
+    @brief  read an input pin, using direct register access with CST816S_FAST_GPIO
+*/
+static inline int IRAM_ATTR pin_read(int pin)
+{
+#if CST816S_FAST_GPIO && CST816S_ESP32
+  return gpio_ll_get_level(&GPIO, static_cast<gpio_num_t>(pin));
+#elif CST816S_FAST_GPIO && defined(ESP8266)
+  if (pin < 16)
+  {
+    return GPIP(pin);
+  }
+  return cst816s_digital_read(pin);
+#else
+  return cst816s_digital_read(pin);
+#endif
+}
+
+// GestureID code to GESTURE, per controller family. 0xFF marks codes the
+// controller never produces, so a report carrying one is rejected.
+#define GESTURE_INVALID 0xFF
+static const uint8_t cst816_gestures[16] = {
+  NONE, SWIPE_UP, SWIPE_DOWN, SWIPE_LEFT, SWIPE_RIGHT, SINGLE_CLICK,
+  GESTURE_INVALID, GESTURE_INVALID, GESTURE_INVALID, GESTURE_INVALID, GESTURE_INVALID,
+  DOUBLE_CLICK, LONG_PRESS,
+  GESTURE_INVALID, GESTURE_INVALID, GESTURE_INVALID,
+};
+// No gesture engine: the register content is meaningless and ignored
+static const uint8_t no_gestures[16] = {};
+
+// What differs between the parts sold as CST816 compatible, keyed by the
+// ChipID register (0xA7)
+struct cst816s_chip {
+  uint8_t chip_id;
+  CHIP_VARIANT variant;
+  uint8_t points;            // touch points in the report block
+  const uint8_t *gestures;   // GestureID decoding table
+  uint8_t standby;           // value written to 0xA5 for standby, 0 = not supported
+};
+
+static const cst816s_chip chip_table[] = {
+  {0xB4, CHIP_CST816S, 1, cst816_gestures, 0x03},
+  {0xB5, CHIP_CST816T, 1, cst816_gestures, 0x03},
+  {0xB6, CHIP_CST816D, 1, cst816_gestures, 0x03},
+  {0xB7, CHIP_CST820,  1, cst816_gestures, 0x03},
+  {0x20, CHIP_CST716,  1, no_gestures,     0x00},
+};
+
+// Unrecognized IDs (or no ID read yet) keep the original generic behaviour
+static const cst816s_chip chip_generic = {0x00, CHIP_UNKNOWN, CST816S_MAX_POINTS, cst816_gestures, 0x03};
 
 /*!
     @brief  Constructor for CST816S
@@ -39,27 +173,162 @@
   @param	irq
       touch interrupt pin
 */
-CST816S::CST816S(int sda, int scl, int rst, int irq)
+#if CST816S_HAL_ARDUINO
+CST816S::CST816S(int sda, int scl, int rst, int irq) : _wire_transport(Wire)
+{
+  _sda = sda;
+  _scl = scl;
+  _rst = rst;
+  _irq = irq;
+  _wire = &Wire;
+  _clock = 0;
+  _transport = &_wire_transport;
+  _chip = &chip_generic;
+}
+
+/*!
+    @brief  Constructor for CST816S on a specific I2C bus
+  @param	sda
+      i2c data pin
+  @param	scl
+      i2c clock pin
+  @param	rst
+      touch reset pin
+  @param	irq
+      touch interrupt pin
+  @param	wire
+      i2c bus to use, e.g. Wire1 to keep the touch controller off the display bus
+  @param	clock
+      i2c clock in Hz, capped at CST816S_I2C_FAST_MODE (0 keeps the bus default)
+*/
+CST816S::CST816S(int sda, int scl, int rst, int irq, TwoWire &wire, uint32_t clock) : _wire_transport(wire)
 {
   _sda = sda;
   _scl = scl;
   _rst = rst;
   _irq = irq;
+  _wire = &wire;
+  _clock = clock > CST816S_I2C_FAST_MODE ? CST816S_I2C_FAST_MODE : clock;
+  _transport = &_wire_transport;
+  _chip = &chip_generic;
+}
+#endif
+
+/*!
+    @brief  Constructor for CST816S on a custom transport
+  @param	rst
+      touch reset pin
+  @param	irq
+      touch interrupt pin
+  @param	transport
+      bus access to use; the caller initializes the underlying bus
+*/
+#if !CST816S_HAL_ARDUINO
+CST816S::CST816S(int rst, int irq, CST816S_Transport &transport)
+#else
+CST816S::CST816S(int rst, int irq, CST816S_Transport &transport) : _wire_transport(Wire)
+#endif
+{
+  _sda = -1;
+  _scl = -1;
+  _rst = rst;
+  _irq = irq;
+  _wire = nullptr;
+  _clock = 0;
+  _transport = &transport;
+  _chip = &chip_generic;
+}
+
+// Configuration registers that may be rewritten from the shadow table.
+// LpScanRaw1H..LpScanRaw2L (0xF0-0xF3) must never be restored from a stale cache.
+static const uint32_t config_rewritable = ~((uint32_t)0xF << (0xF0 - CST816S_CONFIG_FIRST));
+
+/*!
+    @brief  check a report block for values the controller never produces
+
+    Catches reports corrupted on the bus, such as all-0xFF garbage.
+*/
+static bool valid_report(const cst816s_chip *chip, const byte *raw)
+{
+  if ((raw[2] >> 6) == 3)
+  {
+    return false;  // event code 3 is reserved
+  }
+  if (chip->gestures == no_gestures)
+  {
+    return true;  // GestureID is undefined on chips without gestures
+  }
+  return raw[0] < sizeof(cst816_gestures) && chip->gestures[raw[0]] != GESTURE_INVALID;
 }
 
 /*!
     @brief  read touch data
+
+    The report block is fetched in one burst starting at GestureID (0x01),
+    with only as many points as the detected chip reports.
+  @param	event
+      sample to decode the touch report into, left undefined on failure
+  @return CST816S_OK, a transfer error or CST816S_ERR_BAD_FRAME
 */
-void CST816S::read_touch()
+uint8_t CST816S::read_touch(touch_event &event)
 {
-  byte data_raw[8];
-  i2c_read(CST816S_ADDRESS, 0x01, data_raw, 6);
+  byte data_raw[CST816S_REPORT_SIZE] = {};
+  int points = _chip->points < CST816S_MAX_POINTS ? _chip->points : CST816S_MAX_POINTS;
+  size_t length = 2 + CST816S_POINT_SIZE * points;
+#if CST816S_STATS
+  uint32_t start = cst816s_micros();
+  uint8_t result = i2c_read(_address, 0x01, data_raw, length);
+  stats_read(start);
+#else
+  uint8_t result = i2c_read(_address, 0x01, data_raw, length);
+#endif
+  if (result)
+  {
+    return result;
+  }
+  if (_recorder != nullptr)
+  {
+    _recorder->record(event.timestamp, data_raw, CST816S_REPORT_SIZE);
+  }
+  if (!valid_report(_chip, data_raw))
+  {
+    _health.bad_frames++;
+    _health.last_error = CST816S_ERR_BAD_FRAME;
+    return CST816S_ERR_BAD_FRAME;
+  }
+
+  event.gestureID = data_raw[0] < sizeof(cst816_gestures) ? _chip->gestures[data_raw[0]] : (uint8_t)NONE;
+  event.points = data_raw[1];
+
+  for (int i = 0; i < CST816S_MAX_POINTS; i++)
+  {
+    const byte *raw = &data_raw[2 + i * CST816S_POINT_SIZE];
+    touch_point &point = event.point[i];
+    point.event = raw[0] >> 6;
+    point.id = raw[2] >> 4;
+    point.x = ((raw[0] & 0xF) << 8) + raw[1];
+    point.y = ((raw[2] & 0xF) << 8) + raw[3];
+    point.pressure = raw[4];
+    point.area = raw[5];
 
-  data.gestureID = data_raw[0];
-  data.points = data_raw[1];
-  data.event = data_raw[2] >> 6;
-  data.x = ((data_raw[2] & 0xF) << 8) + data_raw[3];
-  data.y = ((data_raw[4] & 0xF) << 8) + data_raw[5];
+    if (_transform != nullptr)
+    {
+      _transform->map(point.x, point.y);
+    }
+  }
+
+  event.event = event.point[0].event;
+  event.x = event.point[0].x;
+  event.y = event.point[0].y;
+  return CST816S_OK;
+}
+
+/*!
+    @brief  static interrupt entry point, forwards to the instance passed as arg
+*/
+void CST816S::isr_trampoline(void *arg)
+{
+  static_cast<CST816S *>(arg)->handleISR();
 }
 
 /*!
@@ -67,12 +336,41 @@ void CST816S::read_touch()
 */
 void CST816S::handleISR(void)
 {
+  _irq_count = _irq_count + 1;
+
+  // A glitch too short to be a controller pulse is over by the time we get
+  // here; the controller holds the line for IrqPluseWidth (1 ms by default)
+  if (_irq_level >= 0 && pin_read(_irq) != _irq_level) {
+    _irq_glitches = _irq_glitches + 1;
+    return;
+  }
+
+#if CST816S_STATS
+  _stat_irqs = _stat_irqs + 1;
+  if (_event_available) {
+    _stat_missed = _stat_missed + 1;
+  }
+#endif
+  _irq_time = cst816s_micros();
   _event_available = true;
 
+#if CST816S_ESP32
+  // Wake the acquisition task; it does the I2C read in task context
+  if (_task != nullptr) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(_task, &woken);
+    portYIELD_FROM_ISR(woken);
+  }
+#endif
+
+#if CST816S_USER_ISR
   // Call user callback if it has been set
-  if (userISR != nullptr) {
+  if (userISRArg != nullptr) {
+      userISRArg(userArg);
+  } else if (userISR != nullptr) {
       userISR();
   }
+#endif
 }
 
 
@@ -82,7 +380,7 @@ void CST816S::handleISR(void)
 void CST816S::enable_double_click(void)
 {
   byte enableDoubleTap = 0x01; // Set EnDClick (bit0) to enable double-tap
-  i2c_write(CST816S_ADDRESS, 0xEC, &enableDoubleTap, 1);
+  config_write(0xEC, enableDoubleTap);
 }
 
 /*!
@@ -102,7 +400,7 @@ void CST816S::enable_double_click(void)
 */
 void CST816S::set_motion_mask(uint8_t mask)
 {
-  i2c_write(CST816S_ADDRESS, 0xEC, &mask, 1);
+  config_write(0xEC, mask);
 }
 
 /*!
@@ -129,7 +427,7 @@ void CST816S::set_motion_mask(uint8_t mask)
 */
 void CST816S::set_irq_control(uint8_t mask)
 {
-  i2c_write(CST816S_ADDRESS, 0xFA, &mask, 1);
+  config_write(0xFA, mask);
 }
 
 
@@ -138,11 +436,15 @@ void CST816S::set_irq_control(uint8_t mask)
 */
 void CST816S::enable_double_click_interrupt_only(void)
 {
+  begin_config();
+
   // 1) Only enable double-tap in MotionMask (0xEC: EnDClick = bit0)
   set_motion_mask(0x01);   // EnDClick
 
   // 2) Configure IrqCtl (0xFA) to only raise IRQ on motion events (EnMotion = bit4)
   set_irq_control(0x10);   // EnMotion
+
+  apply_config();
 }
 
 
@@ -152,7 +454,7 @@ void CST816S::enable_double_click_interrupt_only(void)
 void CST816S::disable_auto_sleep(void)
 {
   byte disableAutoSleep = 0xFE; // Non-zero value disables auto sleep
-  i2c_write(CST816S_ADDRESS, 0xFE, &disableAutoSleep, 1);
+  config_write(0xFE, disableAutoSleep);
 }
 
 /*!
@@ -161,7 +463,7 @@ void CST816S::disable_auto_sleep(void)
 void CST816S::enable_auto_sleep(void)
 {
   byte enableAutoSleep = 0x00; // 0 value enables auto sleep
-  i2c_write(CST816S_ADDRESS, 0xFE, &enableAutoSleep, 1);
+  config_write(0xFE, enableAutoSleep);
 }
 
 /*!
@@ -180,154 +482,2175 @@ void CST816S::set_auto_sleep_time(int seconds)
   }
 
   byte sleepTime = static_cast<byte>(seconds); // Convert int to byte
-  i2c_write(CST816S_ADDRESS, 0xF9, &sleepTime, 1);
+  config_write(0xF9, sleepTime);
 }
 
 /*!
-    @brief  initialize the touch screen
-  @param	interrupt
-      type of interrupt FALLING, RISING..
+    @brief  Start batching configuration changes
+
+    Until apply_config() is called, the configuration setters only update
+    the shadow register table instead of writing to the controller.
 */
-void CST816S::begin(int interrupt)
+void CST816S::begin_config(void)
+{
+  _config_batch = true;
+}
+
+/*!
+    @brief  Write all changed configuration registers to the controller
+
+    Dirty registers are grouped into contiguous bursts. Clean registers
+    lying between two dirty ones are rewritten with their cached value to
+    join the bursts, except the low-power scan references (0xF0-0xF3), which
+    the controller recalibrates on its own.
+  @return 0 on success, non-zero if a burst failed (its registers stay dirty)
+*/
+uint8_t CST816S::apply_config(void)
 {
-  Wire.begin(_sda, _scl);
+  BUS_GUARD();
+  uint8_t result = 0;
 
-  pinMode(_irq, INPUT_PULLUP);
-  pinMode(_rst, OUTPUT);
+  _config_batch = false;
 
-  digitalWrite(_rst, HIGH);
-  delay(50);
-  digitalWrite(_rst, LOW);
-  delay(5);
-  digitalWrite(_rst, HIGH);
-  delay(50);
+  int i = 0;
+  while (i < CST816S_CONFIG_SIZE)
+  {
+    if (!(_config_dirty & (1UL << i)))
+    {
+      i++;
+      continue;
+    }
 
-  i2c_read(CST816S_ADDRESS, 0x15, &data.version, 1);
-  delay(5);
-  i2c_read(CST816S_ADDRESS, 0xA7, data.versionInfo, 3);
+    int end = i;
+    for (int j = i + 1; j < CST816S_CONFIG_SIZE; j++)
+    {
+      uint32_t bit = 1UL << j;
+      if (_config_dirty & bit)
+      {
+        end = j;
+      }
+      else if (!(_config_known & config_rewritable & bit))
+      {
+        break;
+      }
+    }
 
-  attachInterrupt(_irq, std::bind(&CST816S::handleISR, this), interrupt);
+    size_t length = end - i + 1;
+    uint8_t error = i2c_write(_address, CST816S_CONFIG_FIRST + i, &_config[i], length);
+    if (error)
+    {
+      result = error;
+    }
+    else
+    {
+      uint32_t burst = ((1UL << length) - 1) << i;
+      _config_dirty &= ~burst;
+      _config_known |= burst;
+    }
+    i = end + 1;
+  }
+  return result;
 }
 
 /*!
-    @brief  Attaches a user-defined callback function to be triggered on an interrupt event from the CST816S touch controller.
-    @param  callback  A function to be called when an interrupt event occurs, must have no parameters and return void.
+    @brief  Read all configuration registers into the shadow table in one burst
+  @return 0 on success
 */
-void CST816S::attachUserInterrupt(std::function<void(void)> callback)
+uint8_t CST816S::load_config(void)
 {
-  userISR = callback;
+  BUS_GUARD();
+  uint8_t result = i2c_read(_address, CST816S_CONFIG_FIRST, _config, CST816S_CONFIG_SIZE);
+  if (result == 0)
+  {
+    _config_known = (1UL << CST816S_CONFIG_SIZE) - 1;
+    _config_dirty = 0;
+  }
+  return result;
 }
 
 /*!
-    @brief  check for a touch event
+    @brief  Read a block of consecutive registers in one transaction
+  @param	reg
+      first register address
+  @param	values
+      array to copy the register values into
+  @param	length
+      number of registers
+  @return 0 on success
 */
-bool CST816S::available()
+uint8_t CST816S::read_registers(uint8_t reg, uint8_t *values, size_t length)
 {
-  if (_event_available)
+  BUS_GUARD();
+  uint8_t result = i2c_read(_address, reg, values, length);
+  if (result == 0)
   {
-    read_touch();
-    _event_available = false;
-    return true;
+    config_update(reg, values, length);
   }
-  return false;
+  return result;
 }
 
 /*!
-    @brief  put the touch screen in standby mode
+    @brief  Write a block of consecutive registers in one transaction
+  @param	reg
+      first register address
+  @param	values
+      register values to write
+  @param	length
+      number of registers
+  @return 0 on success
 */
-void CST816S::sleep()
+uint8_t CST816S::write_registers(uint8_t reg, const uint8_t *values, size_t length)
 {
-  digitalWrite(_rst, LOW);
-  delay(5);
-  digitalWrite(_rst, HIGH);
-  delay(50);
-  byte standby_value = 0x03;
-  i2c_write(CST816S_ADDRESS, 0xA5, &standby_value, 1);
+  BUS_GUARD();
+  uint8_t result = i2c_write(_address, reg, values, length);
+  if (result == 0)
+  {
+    config_update(reg, values, length);
+  }
+  return result;
 }
 
 /*!
-    @brief  get the gesture event name
+    @brief  Stage a configuration register write
+
+    The write is skipped when the cached value already matches, and deferred
+    while a begin_config() batch is open.
 */
-String CST816S::gesture()
+void CST816S::config_write(uint8_t reg, uint8_t value)
 {
-  switch (data.gestureID)
+  BUS_GUARD();
+  int i = reg - CST816S_CONFIG_FIRST;
+  uint32_t bit = 1UL << i;
+
+  if ((_config_known & bit) && !(_config_dirty & bit) && _config[i] == value)
   {
-  case NONE:
-    return "NONE";
-    break;
-  case SWIPE_DOWN:
-    return "SWIPE DOWN";
-    break;
-  case SWIPE_UP:
-    return "SWIPE UP";
-    break;
-  case SWIPE_LEFT:
-    return "SWIPE LEFT";
-    break;
-  case SWIPE_RIGHT:
-    return "SWIPE RIGHT";
-    break;
-  case SINGLE_CLICK:
-    return "SINGLE CLICK";
-    break;
-  case DOUBLE_CLICK:
-    return "DOUBLE CLICK";
+    return;
+  }
+  _config[i] = value;
+  _config_dirty |= bit;
+
+  if (!_config_batch)
+  {
+    apply_config();
+  }
+}
+
+/*!
+    @brief  Keep the shadow table coherent with a raw register transfer
+*/
+void CST816S::config_update(uint8_t reg, const uint8_t *values, size_t length)
+{
+  for (size_t n = 0; n < length; n++)
+  {
+    int i = reg + n - CST816S_CONFIG_FIRST;
+    if (i >= 0 && i < CST816S_CONFIG_SIZE)
+    {
+      _config[i] = values[n];
+      _config_known |= 1UL << i;
+      _config_dirty &= ~(1UL << i);
+    }
+  }
+}
+
+/*!
+    @brief  initialize the touch screen
+  @param	interrupt
+      type of interrupt FALLING, RISING..
+*/
+void CST816S::begin(int interrupt)
+{
+  init_io();
+
+#if CST816S_RESET_PIN
+  pin_write(_rst, HIGH);
+  cst816s_delay(50);
+  pin_write(_rst, LOW);
+  cst816s_delay(5);
+  pin_write(_rst, HIGH);
+  cst816s_delay(50);
+  _config_known = 0;  // reset restores the controller defaults
+  _reset_state = RESET_IDLE;
+#endif
+
+  i2c_read(_address, 0x15, &data.version, 1);
+  cst816s_delay(5);
+  i2c_read(_address, 0xA7, data.versionInfo, 3);
+  detect_chip();
+
+  enter_power_mode(POWER_ACTIVE);  // a reset leaves the controller awake
+  attach_irq(interrupt);
+}
+
+/*!
+    @brief  initialize the touch screen without fixed boot delays
+
+    Instead of waiting a fixed 105 ms around the reset pulse, the chip ID
+    register is polled until the controller answers.
+  @param	interrupt
+      type of interrupt FALLING, RISING..
+  @param	timeout
+      maximum time in ms to wait for the controller after reset
+  @return true if the controller answered within the timeout
+*/
+bool CST816S::begin_fast(int interrupt, uint32_t timeout)
+{
+  init_io();
+  reset_pulse();
+
+  bool ready = wait_ready(timeout);
+  finish_begin(interrupt, ready);
+  return ready;
+}
+
+/*!
+    @brief  start initializing the touch screen without blocking
+
+    Drive the boot with begin_async_poll() from your setup loop while the
+    rest of the system initializes.
+  @param	interrupt
+      type of interrupt FALLING, RISING..
+  @param	timeout
+      maximum time in ms to wait for the controller after reset
+*/
+void CST816S::begin_async(int interrupt, uint32_t timeout)
+{
+  init_io();
+
+  _boot_interrupt = interrupt;
+  _boot_timeout = timeout;
+  _boot_start = cst816s_millis();
+
+#if CST816S_RESET_PIN
+  pin_write(_rst, LOW);
+  _config_known = 0;
+  _reset_state = RESET_IDLE;
+  _boot_state = BOOT_RESET;
+#else
+  _boot_probe = _boot_start - CST816S_BOOT_PROBE_MS;
+  _boot_state = BOOT_WAIT;
+#endif
+}
+
+/*!
+    @brief  advance the boot started by begin_async()
+  @return BOOT_READY or BOOT_TIMEOUT once finished, the current stage otherwise
+*/
+BOOT_STATE CST816S::begin_async_poll()
+{
+  uint32_t now = cst816s_millis();
+
+  switch (_boot_state)
+  {
+  case BOOT_RESET:
+    if (now - _boot_start >= CST816S_RESET_PULSE_MS)
+    {
+      pin_write(_rst, HIGH);
+      _boot_start = now;
+      _boot_probe = now - CST816S_BOOT_PROBE_MS;
+      _boot_state = BOOT_WAIT;
+    }
     break;
-  case LONG_PRESS:
-    return "LONG PRESS";
+  case BOOT_WAIT:
+    // Probe at most every CST816S_BOOT_PROBE_MS, however often we are polled
+    if (now - _boot_probe >= CST816S_BOOT_PROBE_MS)
+    {
+      _boot_probe = now;
+      if (probe())
+      {
+        _boot_state = BOOT_READY;
+        finish_begin(_boot_interrupt, true);
+        break;
+      }
+    }
+    if (now - _boot_start >= _boot_timeout)
+    {
+      _boot_state = BOOT_TIMEOUT;
+      finish_begin(_boot_interrupt, false);
+    }
     break;
   default:
-    return "UNKNOWN";
     break;
   }
+  return _boot_state;
 }
 
 /*!
-    @brief  read data from i2c
-  @param	addr
-      i2c device address
-  @param	reg_addr
-      device register address
-  @param	reg_data
-      array to copy the read data
-  @param	length
-      length of data
+    @brief  attach the interrupt, or fall back to polling without an IRQ pin
 */
-uint8_t CST816S::i2c_read(uint16_t addr, uint8_t reg_addr, uint8_t *reg_data, size_t length)
+void CST816S::attach_irq(int interrupt)
+{
+  _irq_mode = interrupt;
+  update_irq_level();
+  if (_irq >= 0)
+  {
+    cst816s_attach_irq(_irq, isr_trampoline, this, interrupt);
+  }
+  else if (!_poll_active)
+  {
+    set_polling(CST816S_POLL_ACTIVE_US, CST816S_POLL_IDLE_US);
+  }
+}
+
+/*!
+    @brief  start the i2c bus and configure the reset and interrupt pins
+*/
+void CST816S::init_io()
 {
-  Wire.beginTransmission(addr);
-  Wire.write(reg_addr);
-  if (Wire.endTransmission(true))
-    return -1;
-  Wire.requestFrom(addr, length, true);
-  for (int i = 0; i < length; i++)
+  init_bus();
+
+  if (_irq >= 0)
   {
-    *reg_data++ = Wire.read();
+    cst816s_pin_mode(_irq, INPUT_PULLUP);
   }
-  return 0;
+#if CST816S_RESET_PIN
+  // Set the output latch before enabling the driver: after a deep sleep
+  // reset it reads 0, and driving RST low would hold the controller in
+  // reset, so resume() could never find it still configured
+#if CST816S_ESP32
+  gpio_set_level(static_cast<gpio_num_t>(_rst), HIGH);  // digitalWrite() ignores unconfigured pins
+#else
+  cst816s_digital_write(_rst, HIGH);
+#endif
+  cst816s_pin_mode(_rst, OUTPUT);
+  pin_write(_rst, HIGH);
+#endif
 }
 
 /*!
-    @brief  write data to i2c
-  @brief  read data from i2c
-  @param	addr
-      i2c device address
-  @param	reg_addr
-      device register address
-  @param	reg_data
-      data to be sent
-  @param	length
-      length of data
+    @brief  start the i2c bus, unless a custom transport owns it
 */
-uint8_t CST816S::i2c_write(uint8_t addr, uint8_t reg_addr, const uint8_t *reg_data, size_t length)
+void CST816S::init_bus()
+{
+#if CST816S_HAL_ARDUINO
+  if (_wire != nullptr)
+  {
+    _wire->begin(_sda, _scl);
+    if (_clock)
+    {
+      _wire->setClock(_clock);
+    }
+  }
+#endif
+}
+
+/*!
+    @brief  pulse the reset line and invalidate the cached configuration
+
+    Does nothing when built with CST816S_RESET_PIN set to 0.
+*/
+void CST816S::reset_pulse()
+{
+#if CST816S_RESET_PIN
+  pin_write(_rst, LOW);
+  cst816s_delay(CST816S_RESET_PULSE_MS);
+  pin_write(_rst, HIGH);
+  _config_known = 0;
+  _reset_state = RESET_IDLE;  // supersedes a deferred recovery reset
+#endif
+}
+
+/*!
+    @brief  check whether the controller answers on the bus
+  @return true if the chip ID register could be read
+*/
+bool CST816S::probe()
+{
+  uint8_t chip_id;
+  return i2c_read_once(0xA7, &chip_id, 1) == CST816S_OK;
+}
+
+/*!
+    @brief  poll the controller until it answers after a reset
+  @param	timeout
+      maximum time to wait in ms
+  @return true if the controller answered
+*/
+bool CST816S::wait_ready(uint32_t timeout)
+{
+  uint32_t start = cst816s_millis();
+  while (!probe())
+  {
+    if (cst816s_millis() - start >= timeout)
+    {
+      return false;
+    }
+    cst816s_delay(1);
+  }
+  return true;
+}
+
+/*!
+    @brief  read version information and attach the interrupt
+  @param	interrupt
+      type of interrupt FALLING, RISING..
+  @param	ready
+      false after a boot timeout: the version reads are skipped, as their
+      retries and bus recovery would block for longer than the timeout,
+      and the generic chip profile is used
+*/
+void CST816S::finish_begin(int interrupt, bool ready)
+{
+  if (ready)
+  {
+    i2c_read(_address, 0x15, &data.version, 1);
+    i2c_read(_address, 0xA7, data.versionInfo, 3);
+    detect_chip();
+  }
+  else
+  {
+    _chip = &chip_generic;
+  }
+
+  enter_power_mode(POWER_ACTIVE);  // a reset leaves the controller awake
+  attach_irq(interrupt);
+}
+
+#if CST816S_ESP32
+/*!
+    @brief  initialize the touch screen and start a background acquisition task
+
+    The task sleeps on a task notification given by the ISR, reads each report
+    and publishes it to the event queue, so available(), pop() and
+    read_events() never wait on the I2C bus. From then on every register
+    access (transfers, configuration setters, set_power_mode()) holds a
+    recursive bus mutex, so calls from loop() cannot interleave with the
+    task's reads or race it on the shadow table and health counters.
+  @param	interrupt
+      type of interrupt FALLING, RISING..
+  @param	core
+      core to pin the task to
+  @param	priority
+      FreeRTOS priority of the task
+  @return true if the task was created
+*/
+bool CST816S::begin_task(int interrupt, BaseType_t core, UBaseType_t priority)
 {
-  Wire.beginTransmission(addr);
-  Wire.write(reg_addr);
-  for (int i = 0; i < length; i++)
+  begin(interrupt);
+
+  if (_task != nullptr)
+  {
+    return true;
+  }
+  if (_bus_lock == nullptr)
+  {
+    _bus_lock = xSemaphoreCreateRecursiveMutex();
+    if (_bus_lock == nullptr)
+    {
+      return false;
+    }
+  }
+  return xTaskCreatePinnedToCore(task_loop, "cst816s", CST816S_TASK_STACK_SIZE, this,
+                                 priority, &_task, core) == pdPASS;
+}
+
+/*!
+    @brief  body of the background acquisition task
+*/
+void CST816S::task_loop(void *arg)
+{
+  CST816S *touch = static_cast<CST816S *>(arg);
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, touch->task_wait());
+    touch->task_step();
+  }
+}
+
+/*!
+    @brief  how long the acquisition task may sleep before it has work
+*/
+TickType_t CST816S::task_wait() const
+{
+  // A report held back by set_min_interval() must still be read once the
+  // interval expires, even if no further IRQ arrives
+  TickType_t wait = portMAX_DELAY;
+  if (_reset_state != RESET_IDLE)
+  {
+    return 1;  // a recovery reset advances on every pass
+  }
+  if (_event_available && _min_interval)
+  {
+    wait = pdMS_TO_TICKS(_min_interval / 1000) + 1;
+  }
+  if (_poll_active)
+  {
+    TickType_t poll = pdMS_TO_TICKS(_poll_interval / 1000) + 1;
+    wait = poll < wait ? poll : wait;
+  }
+  return wait;
+}
+
+/*!
+    @brief  one pass of the acquisition task
+*/
+void CST816S::task_step()
+{
+  if (_async_state.load(std::memory_order_acquire) == ASYNC_PENDING)
+  {
+    complete_async();
+  }
+  acquire();
+}
+#endif
+
+/*!
+    @brief  Attaches a user-defined callback function to be triggered on an interrupt event from the CST816S touch controller.
+    @param  callback  A function to be called when an interrupt event occurs, must have no parameters and return void.
+                      It runs in interrupt context, so place it in IRAM (IRAM_ATTR).
+*/
+#if CST816S_USER_ISR
+void CST816S::attachUserInterrupt(void (*callback)(void))
+{
+  userISRArg = nullptr;
+  userISR = callback;
+}
+
+/*!
+    @brief  Attaches a user-defined callback function with a context pointer to be triggered on an interrupt event.
+    @param  callback  A function to be called when an interrupt event occurs, receives arg.
+                      It runs in interrupt context, so place it in IRAM (IRAM_ATTR).
+    @param  arg       Context pointer passed to the callback, e.g. an object instance.
+*/
+void CST816S::attachUserInterrupt(void (*callback)(void *), void *arg)
+{
+  userISR = nullptr;
+  userArg = arg;
+  userISRArg = callback;
+}
+#endif
+
+/*!
+    @brief  check for a touch event
+
+    Drains the event queue one sample at a time into `data`, so samples
+    captured by service() while the caller was busy are not lost.
+*/
+bool CST816S::available()
+{
+  touch_event event;
+  if (!pop(event))
+  {
+    return false;
+  }
+
+  // Seqlock write side: an odd sequence marks the update in progress
+  uint32_t seq = _data_seq.load(std::memory_order_relaxed);
+  _data_seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  data.gestureID = event.gestureID;
+  data.points = event.points;
+  data.event = event.event;
+  data.x = event.x;
+  data.y = event.y;
+  memcpy(data.point, event.point, sizeof(data.point));
+
+  _data_seq.store(seq + 2, std::memory_order_release);
+  return true;
+}
+
+/*!
+    @brief  get a consistent copy of `data` from any task or core
+
+    Lock-free: the copy is retried if available() updated `data` while it
+    was being taken, so X/Y never come from different samples. Only one
+    task may call available().
+  @return copy of the latest touch data
+*/
+data_struct CST816S::snapshot() const
+{
+  data_struct copy;
+  uint32_t before;
+  uint32_t after;
+  do
+  {
+    before = _data_seq.load(std::memory_order_acquire);
+    copy = data;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = _data_seq.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+  return copy;
+}
+
+/*!
+    @brief  read a pending touch report into the event queue
+
+    Call this as close to the interrupt as your application allows (a high
+    priority task, or between chunks of long-running work) to capture every
+    report without consuming it. The sample is timestamped with the IRQ time.
+    If the queue is full the new sample is dropped and counted.
+
+    Does nothing while the background task started by begin_task() is
+    running, since the task is then the only producer.
+*/
+void CST816S::service()
+{
+#if CST816S_ESP32
+  if (_task != nullptr)
+  {
+    return;
+  }
+#endif
+  acquire();
+}
+
+/*!
+    @brief  poll the controller if polling is enabled, then capture a pending report
+*/
+void CST816S::acquire()
+{
+  check_storm();
+  if (service_reset())
+  {
+    return;
+  }
+  if (_poll_active)
+  {
+    poll_controller();
+  }
+  capture();
+}
+
+/*!
+    @brief  poll the finger count and mark a report pending when touched
+
+    A single byte read of FingerNum (0x02) decides whether the full report
+    is worth reading. The poll interval drops to the active rate while a
+    finger is down and doubles up to the idle rate otherwise.
+*/
+void CST816S::poll_controller()
+{
+  uint32_t now = cst816s_micros();
+  if (now - _poll_last < _poll_interval)
+  {
+    return;
+  }
+  _poll_last = now;
+
+  uint8_t fingers = 0;
+  if (i2c_read_once(0x02, &fingers, 1))
+  {
+    // The controller does not answer in standby; wait at the idle rate
+    _poll_interval = _poll_idle;
+    return;
+  }
+
+  // Read while touched, plus once after lift-off for the up event and gesture
+  if (fingers || _poll_touching)
+  {
+    _irq_time = now;
+    _event_available = true;
+    _poll_interval = _poll_active;
+  }
+  else if (_poll_interval < _poll_idle)
+  {
+    _poll_interval = _poll_interval * 2 < _poll_idle ? _poll_interval * 2 : _poll_idle;
+  }
+  _poll_touching = fingers != 0;
+}
+
+/*!
+    @brief  read a pending touch report and push it to the event queue
+*/
+void CST816S::capture()
+{
+  if (!_event_available)
+  {
+    return;
+  }
+
+  // Leave the report pending until the minimum interval has passed, so all
+  // IRQs within it are merged into a single read of the newest position
+  uint32_t now = cst816s_micros();
+  if (_min_interval && now - _last_read < _min_interval)
+  {
+    return;
+  }
+  _last_read = now;
+
+  // Clear the flag before reading so an IRQ raised during the transfer is kept
+  _event_available = false;
+
+  // Between touches, GestureID and FingerNum tell whether the interrupt
+  // carried anything; two bytes instead of the whole report block
+  if (_precheck && !_precheck_touching)
+  {
+    uint8_t head[2];
+    if (i2c_read_once(0x01, head, 2) == CST816S_OK && head[0] == NONE && head[1] == 0)
+    {
+      _precheck_skipped++;
+      return;
+    }
+  }
+
+  touch_event event;
+  event.timestamp = _irq_time;
+  if (read_touch(event))
+  {
+    return;  // a failed or corrupted read is dropped, never decoded as a touch
+  }
+  _precheck_touching = event.points != 0;
+#if CST816S_TELEMETRY
+  telemetry_sample(event);
+#endif
+
+  if (_filter != nullptr && !_filter->apply(event))
+  {
+    return;
+  }
+  queue_sample(event);
+
+  // A debounced touch released without contact samples comes out of the
+  // filter as a touch down, followed by the release
+  if (_filter != nullptr && _filter->release(event))
+  {
+    queue_sample(event);
+  }
+}
+
+/*!
+    @brief  run prediction and the change threshold, then queue a sample
+*/
+void CST816S::queue_sample(touch_event &event)
+{
+  if (_predictor != nullptr)
+  {
+    _predictor->apply(event);
+  }
+
+  // Drop contact samples that moved less than the change threshold. The
+  // controller repeats GestureID on every sample of a swipe, so only a
+  // sample whose gesture changed is a boundary that is always kept
+  if (_min_delta && event.event == 2 && event.gestureID == _last_gesture &&
+      abs(event.x - _last_x) < _min_delta && abs(event.y - _last_y) < _min_delta)
+  {
+    return;
+  }
+  _last_x = event.x;
+  _last_y = event.y;
+  _last_gesture = event.gestureID;
+
+  if (!_events.push(event))
+  {
+    _dropped = _dropped + 1;
+  }
+}
+
+/*!
+    @brief  take the next sample from the queue, applying coalescing
+*/
+bool CST816S::next_event(touch_event &event)
+{
+  if (!_events.pop(event))
+  {
+    return false;
+  }
+
+  // Latest sample wins: skip to the newest of a run of contact samples with
+  // the same gesture. The first sample of a new gesture is never skipped
+  touch_event next;
+  while (_coalesce && event.event == 2 && event.gestureID == _coalesce_gesture &&
+         _events.peek(next) && next.event == 2 && next.gestureID == event.gestureID)
+  {
+    _events.pop(event);
+  }
+  _coalesce_gesture = event.gestureID;
+
+#if CST816S_STATS
+  stats_consume(event);
+#endif
+  return true;
+}
+
+/*!
+    @brief  take the oldest queued touch sample
+  @param	event
+      receives the sample
+  @return true if a sample was available
+*/
+bool CST816S::pop(touch_event &event)
+{
+  service();
+  return next_event(event);
+}
+
+/*!
+    @brief  take the oldest queued touch sample without touching the bus
+
+    Unlike pop(), a pending report is not read, so this is safe to call from
+    contexts that must not wait on I2C, such as a UI timer callback, while
+    the acquisition task or service() fills the queue.
+  @param	event
+      receives the sample
+  @return true if a sample was available
+*/
+bool CST816S::pop_queued(touch_event &event)
+{
+  return next_event(event);
+}
+
+/*!
+    @brief  drain queued touch samples in one burst
+  @param	events
+      array to copy the samples into, oldest first
+  @param	max
+      capacity of the array
+  @return number of samples copied
+*/
+size_t CST816S::read_events(touch_event *events, size_t max)
+{
+  service();
+  size_t count = 0;
+  while (count < max && next_event(events[count]))
+  {
+    count++;
+  }
+  return count;
+}
+
+#if CST816S_DISPATCH
+/*!
+    @brief  register a handler for one gesture
+  @param	gesture
+      gesture to handle, e.g. SWIPE_LEFT or LONG_PRESS
+  @param	handler
+      called from dispatch() once per gesture, nullptr to remove
+*/
+void CST816S::on_gesture(GESTURE gesture, touch_event_callback handler)
+{
+  if (gesture < CST816S_GESTURE_SLOTS)
+  {
+    _gesture_handlers[gesture] = handler;
+  }
+}
+
+/*!
+    @brief  register a handler for a touch event type
+  @param	event
+      0 = down, 1 = up, 2 = contact
+  @param	handler
+      called from dispatch() for every matching sample, nullptr to remove
+*/
+void CST816S::on_event(uint8_t event, touch_event_callback handler)
+{
+  if (event < CST816S_EVENT_SLOTS)
+  {
+    _event_handlers[event] = handler;
+  }
+}
+
+/*!
+    @brief  drain queued samples and call the registered handlers
+
+    Runs in the caller's context, after the reports have been read, so
+    handlers may use the bus, allocate or block. The event handler runs
+    first, then the gesture handler. The controller repeats the GestureID
+    in every report until lift-off, so a gesture handler only fires when
+    the gesture changes within a touch.
+  @param	max
+      maximum number of samples to handle, 0 for all pending
+  @return number of samples handled
+*/
+size_t CST816S::dispatch(size_t max)
+{
+  touch_event event;
+  size_t count = 0;
+  while ((max == 0 || count < max) && pop(event))
+  {
+    count++;
+    if (event.event == 0)
+    {
+      _dispatch_gesture = NONE;
+    }
+    if (event.event < CST816S_EVENT_SLOTS && _event_handlers[event.event])
+    {
+      _event_handlers[event.event](event);
+    }
+    if (event.gestureID != _dispatch_gesture)
+    {
+      _dispatch_gesture = event.gestureID;
+      if (event.gestureID < CST816S_GESTURE_SLOTS && _gesture_handlers[event.gestureID])
+      {
+        _gesture_handlers[event.gestureID](event);
+      }
+    }
+    if (event.event == 1)
+    {
+      _dispatch_gesture = NONE;
+    }
+  }
+  return count;
+}
+#endif
+
+/*!
+    @brief  start a touch report read without waiting for the bus
+
+    With the acquisition task running (begin_task()) the transfer is handed
+    to the task and this returns immediately; otherwise the read completes
+    before returning. Either way the result is delivered to `callback` (in
+    task context) and can be collected with read_async_done(). A failed
+    read does not call `callback`; read_async_error() reports it instead.
+  @param	callback
+      optional function called with the decoded report
+  @return false if a previous asynchronous read is still pending
+*/
+bool CST816S::read_async(touch_event_callback callback)
+{
+  if (_async_state.load(std::memory_order_acquire) == ASYNC_PENDING)
+  {
+    return false;
+  }
+  _async_callback = callback;
+  _async_state.store(ASYNC_PENDING, std::memory_order_release);
+
+#if CST816S_ESP32
+  if (_task != nullptr)
+  {
+    xTaskNotifyGive(_task);
+    return true;
+  }
+#endif
+  complete_async();
+  return true;
+}
+
+/*!
+    @brief  poll for the result of read_async()
+  @param	event
+      receives the decoded report once the read has completed
+  @return true if a result was collected
+*/
+bool CST816S::read_async_done(touch_event &event)
+{
+  if (_async_state.load(std::memory_order_acquire) != ASYNC_DONE)
+  {
+    return false;
+  }
+  event = _async_result;
+  _async_state.store(ASYNC_IDLE, std::memory_order_release);
+  return true;
+}
+
+/*!
+    @brief  collect the failure of read_async()
+
+    When read_async_done() keeps returning false, this tells a failed read
+    from one that is still pending.
+  @return the I2C_RESULT of a failed read, once; CST816S_OK while the read
+      is pending, after it succeeded or when no read was started
+*/
+uint8_t CST816S::read_async_error()
+{
+  if (_async_state.load(std::memory_order_acquire) != ASYNC_ERROR)
+  {
+    return CST816S_OK;
+  }
+  uint8_t result = _async_error;
+  _async_state.store(ASYNC_IDLE, std::memory_order_release);
+  return result;
+}
+
+/*!
+    @brief  perform a pending asynchronous read and publish its result
+*/
+void CST816S::complete_async()
+{
+  _async_result.timestamp = cst816s_micros();
+  uint8_t result = read_touch(_async_result);
+  if (result)
+  {
+    _async_callback = nullptr;
+    _async_error = result;
+    _async_state.store(ASYNC_ERROR, std::memory_order_release);
+    return;
+  }
+  // Once DONE is published the application may start the next read and
+  // reassign both, so the callback runs on what this read owns
+  touch_event_callback callback = std::move(_async_callback);
+  _async_callback = nullptr;
+  touch_event event = _async_result;
+  _async_state.store(ASYNC_DONE, std::memory_order_release);
+
+  if (callback != nullptr)
+  {
+    callback(event);
+  }
+}
+
+/*!
+    @brief  mark a touch report as pending, as if the IRQ had fired
+
+    Lets polling loops, replay sources and benchmarks feed the normal event
+    path without a physical interrupt.
+*/
+void CST816S::inject_interrupt()
+{
+  _irq_time = cst816s_micros();
+  _event_available = true;
+
+#if CST816S_ESP32
+  if (_task != nullptr)
+  {
+    xTaskNotifyGive(_task);
+  }
+#endif
+}
+
+/*!
+    @brief  set the minimum time between touch report reads
+
+    Interrupts arriving within the interval are merged into one read of the
+    newest position instead of triggering a read each.
+  @param	us
+      minimum interval in microseconds, 0 to read on every interrupt
+*/
+void CST816S::set_min_interval(uint32_t us)
+{
+  _min_interval = us;
+}
+
+/*!
+    @brief  set the minimum movement for a contact sample to be published
+  @param	pixels
+      samples that moved less than this on both axes are discarded, 0 keeps all
+*/
+void CST816S::set_min_delta(int pixels)
+{
+  _min_delta = pixels;
+}
+
+/*!
+    @brief  only deliver the newest of consecutive queued contact samples
+
+    Touch down/up samples and the first sample of each gesture are always
+    delivered. Contact samples repeating the previous sample's gesture, as
+    the controller reports throughout a swipe, are coalesced like plain ones.
+  @param	enable
+      true to coalesce, false to deliver every sample
+*/
+void CST816S::set_coalescing(bool enable)
+{
+  _coalesce = enable;
+}
+
+/*!
+    @brief  run queued samples through a motion predictor
+  @param	predictor
+      predictor that replaces x/y with the extrapolated position, nullptr to detach
+*/
+void CST816S::set_predictor(CST816S_Predictor *predictor)
+{
+  _predictor = predictor;
+}
+
+/*!
+    @brief  map every report to screen coordinates
+  @param	transform
+      rotation/mirroring/calibration to apply inside the read, nullptr to detach
+*/
+void CST816S::set_transform(CST816S_Transform *transform)
+{
+  _transform = transform;
+}
+
+/*!
+    @brief  run queued samples through a noise rejection filter
+  @param	filter
+      debounce/jump rejection/smoothing stage applied before the predictor, nullptr to detach
+*/
+void CST816S::set_filter(CST816S_Filter *filter)
+{
+  _filter = filter;
+}
+
+/*!
+    @brief  log every raw report frame
+  @param	recorder
+      recorder fed from the read path, nullptr to detach
+*/
+void CST816S::set_recorder(CST816S_Recorder *recorder)
+{
+  _recorder = recorder;
+}
+
+/*!
+    @brief  poll the controller instead of waiting for interrupts
+
+    For boards where the IRQ line is shared or not wired (pass -1 as irq to
+    enable this automatically). Polling runs from service()/available() or
+    from the acquisition task.
+  @param	active_us
+      poll interval while a finger is down, 0 to disable polling
+  @param	idle_us
+      longest poll interval when idle
+*/
+void CST816S::set_polling(uint32_t active_us, uint32_t idle_us)
+{
+  _poll_active = active_us;
+  _poll_idle = idle_us > active_us ? idle_us : active_us;
+  _poll_interval = active_us;
+}
+
+/*!
+    @brief  set the i2c address of the controller
+  @param	address
+      7-bit address, CST816S_ADDRESS (0x15) by default
+*/
+void CST816S::set_address(uint8_t address)
+{
+  _address = address;
+}
+
+/*!
+    @brief  number of samples waiting in the event queue
+*/
+size_t CST816S::events_pending() const
+{
+  return _events.size();
+}
+
+/*!
+    @brief  number of samples discarded because the event queue was full
+*/
+uint32_t CST816S::dropped_events() const
+{
+  return _dropped;
+}
+
+#if CST816S_STATS
+/*!
+    @brief  map a latency to its histogram bucket
+
+    Buckets 0-3 are 1 us wide, after that every power of two is split into
+    four linear sub-buckets, so the p99 estimate is within 25%.
+*/
+static uint8_t latency_bucket(uint32_t us)
+{
+  if (us < 4)
+  {
+    return us;
+  }
+  int msb = 31 - __builtin_clz(us);
+  uint32_t bucket = (msb - 1) * 4 + ((us >> (msb - 2)) & 3);
+  return bucket < CST816S_LATENCY_BUCKETS ? bucket : CST816S_LATENCY_BUCKETS - 1;
+}
+
+/*!
+    @brief  upper bound in us of a histogram bucket
+*/
+static uint32_t latency_bucket_limit(uint8_t bucket)
+{
+  if (bucket < 4)
+  {
+    return bucket;
+  }
+  int shift = bucket / 4 - 1;
+  return ((4 + bucket % 4 + 1) << shift) - 1;
+}
+
+/*!
+    @brief  get a snapshot of the latency and bus statistics
+
+    Counters are updated from the ISR, the reading context and the consuming
+    context; fields of the snapshot may be a few events apart.
+*/
+touch_stats CST816S::stats() const
+{
+  touch_stats result;
+  result.events = _stat_events;
+  result.latency_min = _stat_events ? _stat_latency_min : 0;
+  result.latency_avg = _stat_events ? _stat_latency_sum / _stat_events : 0;
+  result.latency_max = _stat_latency_max;
+  result.latency_p99 = 0;
+  result.reads = _stat_reads;
+  result.read_min = _stat_reads ? _stat_read_min : 0;
+  result.read_avg = _stat_reads ? _stat_read_sum / _stat_reads : 0;
+  result.read_max = _stat_read_max;
+  result.irqs = _stat_irqs;
+  result.missed_irqs = _stat_missed + _dropped;
+  result.nacks = _stat_nacks;
+  result.bytes = _stat_bytes;
+
+  uint32_t target = _stat_events - _stat_events / 100;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < CST816S_LATENCY_BUCKETS && _stat_events; i++)
+  {
+    seen += _stat_latency_hist[i];
+    if (seen >= target)
+    {
+      result.latency_p99 = latency_bucket_limit(i);
+      break;
+    }
+  }
+  return result;
+}
+
+/*!
+    @brief  clear all statistics
+*/
+void CST816S::reset_stats()
+{
+  _stat_irqs = 0;
+  _stat_missed = 0;
+  _stat_events = 0;
+  _stat_latency_min = UINT32_MAX;
+  _stat_latency_max = 0;
+  _stat_latency_sum = 0;
+  memset(_stat_latency_hist, 0, sizeof(_stat_latency_hist));
+  _stat_reads = 0;
+  _stat_read_min = UINT32_MAX;
+  _stat_read_max = 0;
+  _stat_read_sum = 0;
+  _stat_nacks = 0;
+  _stat_bytes = 0;
+}
+
+/*!
+    @brief  record the IRQ-to-consume latency of a sample
+*/
+void CST816S::stats_consume(const touch_event &event)
+{
+  uint32_t latency = cst816s_micros() - event.timestamp;
+  _stat_events++;
+  _stat_latency_sum += latency;
+  if (latency < _stat_latency_min)
+    _stat_latency_min = latency;
+  if (latency > _stat_latency_max)
+    _stat_latency_max = latency;
+  _stat_latency_hist[latency_bucket(latency)]++;
+}
+
+/*!
+    @brief  record the duration of a touch report read
+*/
+void CST816S::stats_read(uint32_t start)
+{
+  uint32_t duration = cst816s_micros() - start;
+  _stat_reads++;
+  _stat_read_sum += duration;
+  if (duration < _stat_read_min)
+    _stat_read_min = duration;
+  if (duration > _stat_read_max)
+    _stat_read_max = duration;
+}
+
+/*!
+    @brief  record the outcome of an I2C transaction
+*/
+void CST816S::stats_transfer(uint8_t result, size_t length)
+{
+  if (result)
+    _stat_nacks++;
+  else
+    _stat_bytes += length;
+}
+#endif
+
+/*!
+    @brief  put the touch screen in standby mode
+
+    Equivalent to set_power_mode(POWER_STANDBY).
+*/
+void CST816S::sleep()
+{
+  set_power_mode(POWER_STANDBY);
+}
+
+// MotionMask (0xEC), IrqCtl (0xFA) and DisAutoSleep (0xFE) per power mode
+struct power_mode_config {
+  uint8_t motion_mask;
+  uint8_t irq_control;
+  uint8_t disable_auto_sleep;
+};
+
+static const power_mode_config power_modes[] = {
+  {0x01, 0x70, 0x00},  // POWER_ACTIVE: EnDClick; EnTouch | EnChange | EnMotion
+  {0x00, 0x70, 0xFE},  // POWER_LOW_LATENCY: single taps without the double-tap wait
+  {0x01, 0x10, 0x00},  // POWER_IDLE_GESTURE_ONLY: EnDClick; EnMotion only
+};
+
+/*!
+    @brief  switch the controller power mode in one batched step
+
+    MotionMask, IrqCtl and auto sleep are written together through the
+    shadow registers, so only what actually changes is sent. Entering
+    POWER_STANDBY only pulses reset when the controller does not answer the
+    standby command directly; leaving it always needs a reset, after which
+    the configuration known before standby is restored from the shadow
+    registers together with the new mode.
+  @param	mode
+      the power mode to switch to
+  @return true on success
+*/
+bool CST816S::set_power_mode(POWER_MODE mode)
+{
+  BUS_GUARD();
+  if (mode >= POWER_MODE_COUNT)
+  {
+    return false;
+  }
+  if (mode == POWER_STANDBY && _power_mode == POWER_STANDBY)
+  {
+    return true;
+  }
+
+  if (mode == POWER_STANDBY)
+  {
+    byte standby_value = _chip->standby;
+    if (!standby_value)
+    {
+      return false;
+    }
+    uint32_t restore = _config_known & config_rewritable;
+    // A controller in auto sleep NACKs this, which is not a bus fault:
+    // a single try keeps retries and bus recovery out of every sleep()
+    uint8_t result = i2c_write_once(0xA5, &standby_value, 1);
+#if CST816S_RESET_PIN
+    if (result)
+    {
+      // Controller is in auto sleep and does not answer: wake it first
+      reset_pulse();
+      wait_ready(50);
+      result = i2c_write(_address, 0xA5, &standby_value, 1);
+    }
+#endif
+    if (result)
+    {
+      // The wake-up reset restored the firmware defaults: keep what the
+      // shadow knew for the next mode change to write back
+      _config_dirty |= restore & ~_config_known;
+      return false;
+    }
+    // Only a reset brings the controller back, with firmware defaults:
+    // everything the shadow knew is written again when leaving standby
+    _config_known = 0;
+    _config_dirty |= restore;
+  }
+  else
+  {
+    if (_power_mode == POWER_STANDBY)
+    {
+#if CST816S_RESET_PIN
+      reset_pulse();
+      if (!wait_ready(CST816S_BOOT_TIMEOUT_MS))
+      {
+        return false;
+      }
+#else
+      return false;
+#endif
+    }
+
+    const power_mode_config &config = power_modes[mode];
+    begin_config();
+    config_write(0xEC, config.motion_mask);
+    config_write(0xFA, config.irq_control);
+    config_write(0xFE, config.disable_auto_sleep);
+    if (apply_config())
+    {
+      return false;
+    }
+  }
+
+  enter_power_mode(mode);
+  return true;
+}
+
+/*!
+    @brief  record a power mode change for power_mode_time()
+*/
+void CST816S::enter_power_mode(POWER_MODE mode)
+{
+  uint32_t now = cst816s_millis();
+  _power_time[_power_mode] += now - _power_since;
+  _power_since = now;
+  _power_mode = mode;
+}
+
+#if CST816S_ESP32
+/*!
+    @brief  save the controller state and arm the IRQ pin as MCU wake source
+
+    Call this right before esp_deep_sleep_start() or esp_light_sleep_start(),
+    typically after set_power_mode(POWER_IDLE_GESTURE_ONLY). Version info,
+    the shadow registers and the power mode are kept in RTC memory so
+    resume() does not have to reset the controller.
+  @param	deep
+      true to arm ext0 wake (deep sleep GPIO wake on chips without ext0) for
+      deep sleep, false to arm GPIO wake for light sleep
+  @return true if the wake source was configured
+*/
+bool CST816S::prepare_sleep(bool deep)
+{
+  rtc_state.version = data.version;
+  memcpy(rtc_state.versionInfo, data.versionInfo, sizeof(rtc_state.versionInfo));
+  rtc_state.power_mode = _power_mode;
+  memcpy(rtc_state.config, _config, sizeof(rtc_state.config));
+  rtc_state.config_known = _config_known & ~_config_dirty;
+  rtc_state.magic = CST816S_RTC_MAGIC;
+
+  if (_irq < 0)
+  {
+    return false;
+  }
+  // IrqCtl events pull the IRQ line low
+  if (deep)
+  {
+#if SOC_PM_SUPPORT_EXT0_WAKEUP
+    return esp_sleep_enable_ext0_wakeup(static_cast<gpio_num_t>(_irq), 0) == ESP_OK;
+#elif SOC_GPIO_SUPPORT_DEEPSLEEP_WAKEUP
+    // ESP32-C3/C6/H2: only the low-power capable GPIOs can wake from deep sleep
+    return esp_deep_sleep_enable_gpio_wakeup(1ULL << _irq, ESP_GPIO_WAKEUP_GPIO_LOW) == ESP_OK;
+#else
+    return false;
+#endif
+  }
+  return gpio_wakeup_enable(static_cast<gpio_num_t>(_irq), GPIO_INTR_LOW_LEVEL) == ESP_OK &&
+         esp_sleep_enable_gpio_wakeup() == ESP_OK;
+}
+
+/*!
+    @brief  resume after MCU light or deep sleep without resetting the controller
+
+    If prepare_sleep() saved the state and the controller still answers,
+    the reset and version reads are skipped. When the MCU was woken by the
+    IRQ pin, the report that triggered it (e.g. the double-tap) is read
+    immediately and queued, since its interrupt fired before the ISR was
+    attached. Falls back to begin_fast() otherwise.
+  @param	interrupt
+      type of interrupt FALLING, RISING..
+  @return true if the controller is ready
+*/
+bool CST816S::resume(int interrupt)
+{
+  if (rtc_state.magic != CST816S_RTC_MAGIC)
+  {
+    return begin_fast(interrupt);
+  }
+
+  init_io();
+  if (_irq >= 0)
+  {
+    gpio_wakeup_disable(static_cast<gpio_num_t>(_irq));
+  }
+  if (!probe())
+  {
+    rtc_state.magic = 0;
+    return begin_fast(interrupt);
+  }
+
+  data.version = rtc_state.version;
+  memcpy(data.versionInfo, rtc_state.versionInfo, sizeof(data.versionInfo));
+  detect_chip();
+  memcpy(_config, rtc_state.config, sizeof(_config));
+  _config_known = rtc_state.config_known;
+  _config_dirty = 0;
+  _power_mode = static_cast<POWER_MODE>(rtc_state.power_mode);
+  _power_since = cst816s_millis();
+
+  attach_irq(interrupt);
+
+  esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  if (cause == ESP_SLEEP_WAKEUP_EXT0 || cause == ESP_SLEEP_WAKEUP_GPIO)
+  {
+    inject_interrupt();
+    capture();
+  }
+  return true;
+}
+#endif
+
+/*!
+    @brief  get the current power mode
+*/
+POWER_MODE CST816S::power_mode() const
+{
+  return _power_mode;
+}
+
+/*!
+    @brief  total time spent in a power mode
+  @param	mode
+      the power mode to query
+  @return time in milliseconds, including the current stay
+*/
+uint32_t CST816S::power_mode_time(POWER_MODE mode) const
+{
+  if (mode >= POWER_MODE_COUNT)
+  {
+    return 0;
+  }
+  uint32_t total = _power_time[mode];
+  if (mode == _power_mode)
+  {
+    total += cst816s_millis() - _power_since;
+  }
+  return total;
+}
+
+#if CST816S_GESTURE_NAMES
+// Gesture names, indexed by gesture ID. Kept in flash (PROGMEM on ESP8266).
+static const char gesture_none[] PROGMEM = "NONE";
+static const char gesture_swipe_up[] PROGMEM = "SWIPE UP";
+static const char gesture_swipe_down[] PROGMEM = "SWIPE DOWN";
+static const char gesture_swipe_left[] PROGMEM = "SWIPE LEFT";
+static const char gesture_swipe_right[] PROGMEM = "SWIPE RIGHT";
+static const char gesture_single_click[] PROGMEM = "SINGLE CLICK";
+static const char gesture_double_click[] PROGMEM = "DOUBLE CLICK";
+static const char gesture_long_press[] PROGMEM = "LONG PRESS";
+static const char gesture_unknown[] PROGMEM = "UNKNOWN";
+
+static const char *const gesture_names[] PROGMEM = {
+  gesture_none,         // 0x00
+  gesture_swipe_up,     // 0x01
+  gesture_swipe_down,   // 0x02
+  gesture_swipe_left,   // 0x03
+  gesture_swipe_right,  // 0x04
+  gesture_single_click, // 0x05
+  gesture_unknown,      // 0x06
+  gesture_unknown,      // 0x07
+  gesture_unknown,      // 0x08
+  gesture_unknown,      // 0x09
+  gesture_unknown,      // 0x0A
+  gesture_double_click, // 0x0B
+  gesture_long_press,   // 0x0C
+};
+
+#if CST816S_HAL_ARDUINO
+/*!
+    @brief  get the gesture event name
+*/
+String CST816S::gesture()
+{
+#if defined(ESP8266)
+  return String(FPSTR(gesture_name(static_cast<GESTURE>(data.gestureID))));
+#else
+  return String(gesture_name(static_cast<GESTURE>(data.gestureID)));
+#endif
+}
+#endif
+
+/*!
+    @brief  get a gesture name without allocating
+
+    On ESP8266 the returned string lives in flash: print it with FPSTR() or
+    use the buffer overload.
+  @param	gesture
+      gesture ID
+  @return the gesture name, "UNKNOWN" for unrecognized IDs
+*/
+const char *CST816S::gesture_name(GESTURE gesture)
+{
+  if (gesture >= sizeof(gesture_names) / sizeof(gesture_names[0]))
+  {
+    return gesture_unknown;
+  }
+  return (const char *)pgm_read_ptr(&gesture_names[gesture]);
+}
+
+/*!
+    @brief  copy a gesture name into a caller-provided buffer
+  @param	gesture
+      gesture ID
+  @param	buffer
+      destination, always null-terminated when size is non-zero
+  @param	size
+      size of the buffer
+  @return length of the copied name
+*/
+size_t CST816S::gesture_name(GESTURE gesture, char *buffer, size_t size)
+{
+  if (size == 0)
+  {
+    return 0;
+  }
+  strncpy_P(buffer, gesture_name(gesture), size - 1);
+  buffer[size - 1] = '\0';
+  return strlen(buffer);
+}
+#endif
+
+/*!
+    @brief  set how hard failed transfers are retried
+
+    A failed transfer is repeated up to `retries` times, waiting
+    CST816S_I2C_BACKOFF_US before the first retry and doubling the wait
+    each time. If it still fails and recovery is enabled, the bus is
+    recovered (at most once per CST816S_RECOVERY_INTERVAL_MS) and the
+    transfer is tried once more. The controller reset that follows runs
+    from service() without blocking.
+  @param	retries
+      extra attempts per transfer, 0 to fail on the first error
+  @param	recovery
+      clock out a stuck bus and reset the controller as a last resort
+*/
+void CST816S::set_retries(uint8_t retries, bool recovery)
+{
+  _retries = retries;
+  _recovery = recovery;
+}
+
+/*!
+    @brief  bus error, retry and recovery counters since begin
+*/
+i2c_health CST816S::health() const
+{
+  return _health;
+}
+
+/*!
+    @brief  pick the chip profile matching the ChipID in data.versionInfo[0]
+*/
+void CST816S::detect_chip()
+{
+  _chip = &chip_generic;
+  for (size_t i = 0; i < sizeof(chip_table) / sizeof(chip_table[0]); i++)
+  {
+    if (chip_table[i].chip_id == data.versionInfo[0])
+    {
+      _chip = &chip_table[i];
+      return;
+    }
+  }
+}
+
+/*!
+    @brief  controller variant detected from the ChipID register by begin()
+*/
+CHIP_VARIANT CST816S::chip() const
+{
+  return _chip->variant;
+}
+
+/*!
+    @brief  override the detected controller variant
+
+    For parts that report an unexpected ChipID.
+  @param	variant
+      variant whose report length, gesture table and sleep command to use,
+      CHIP_UNKNOWN for the generic behaviour
+*/
+void CST816S::set_chip(CHIP_VARIANT variant)
+{
+  _chip = &chip_generic;
+  for (size_t i = 0; i < sizeof(chip_table) / sizeof(chip_table[0]); i++)
+  {
+    if (chip_table[i].variant == variant)
+    {
+      _chip = &chip_table[i];
+      return;
+    }
+  }
+}
+
+/*!
+    @brief  filter interrupts and reads that carry no touch data
+  @param	level
+      in the ISR, ignore falling edges after which the IRQ pin is no longer
+      low (FALLING interrupts only, ignored otherwise)
+  @param	precheck
+      between touches, read GestureID and FingerNum first and skip the full
+      report read when both are zero
+*/
+void CST816S::set_irq_check(bool level, bool precheck)
+{
+  _irq_check_level = level;
+  _precheck = precheck;
+  update_irq_level();
+}
+
+/*!
+    @brief  work out the pin level the ISR should see after a real edge
+*/
+void CST816S::update_irq_level()
+{
+  if (!_irq_check_level || _irq < 0)
+  {
+    _irq_level = -1;
+  }
+  else if (_irq_mode == FALLING)
+  {
+    // The controller holds IRQ low for IrqPluseWidth, a noise spike is over
+    _irq_level = LOW;
+  }
+  else
+  {
+    // After a rising edge the line is high whether the low phase was a
+    // real pulse or a spike, so the check could never reject anything
+    _irq_level = -1;
+  }
+}
+
+/*!
+    @brief  protect the CPU from a stuck or noisy IRQ line
+
+    When more than `max_irqs` interrupts arrive within
+    CST816S_STORM_WINDOW_MS, the interrupt is detached and the controller
+    is polled at the default polling rates instead. After `backoff_ms` the
+    interrupt is re-armed. Checked from service() or the acquisition task.
+  @param	max_irqs
+      interrupts per window treated as a storm, 0 to disable
+  @param	backoff_ms
+      time spent polling before re-arming the interrupt
+*/
+void CST816S::set_storm_protection(uint32_t max_irqs, uint32_t backoff_ms)
+{
+  _storm_limit = max_irqs;
+  _storm_backoff = backoff_ms;
+}
+
+/*!
+    @brief  interrupt counters and storm state
+*/
+irq_health CST816S::irq_status() const
+{
+  irq_health status;
+  status.irqs = _irq_count;
+  status.glitches = _irq_glitches;
+  status.skipped = _precheck_skipped;
+  status.storms = _storms;
+  status.storm = _storm;
+  return status;
+}
+
+#if CST816S_TELEMETRY
+/*!
+    @brief  telemetry counter index of a gesture, -1 for NONE or unknown IDs
+*/
+static int telemetry_gesture_slot(uint8_t gesture)
+{
+  if (gesture >= SWIPE_UP && gesture <= SINGLE_CLICK)
+    return gesture - SWIPE_UP;
+  if (gesture == DOUBLE_CLICK)
+    return 5;
+  if (gesture == LONG_PRESS)
+    return 6;
+  return -1;
+}
+
+/*!
+    @brief  append an LEB128 varint, false if it does not fit
+*/
+static bool telemetry_put(uint8_t *buffer, size_t size, size_t &pos, uint32_t value)
+{
+  do
+  {
+    if (pos >= size)
+      return false;
+    uint8_t b = value & 0x7F;
+    value >>= 7;
+    buffer[pos++] = value ? (b | 0x80) : b;
+  } while (value);
+  return true;
+}
+
+/*!
+    @brief  count gestures and touch durations from a decoded report
+
+    Called from capture() only, once per reported interrupt; read_async()
+    re-reads whatever the registers hold and is not counted. A gesture is
+    counted once per change within a touch, as the controller repeats
+    GestureID in every report until the finger lifts.
+*/
+void CST816S::telemetry_sample(const touch_event &event)
+{
+  // Event: 0 = Down, 1 = Up, 2 = Contact
+  if (event.event == 0 && event.points)
+  {
+    _tel_touching = true;
+    _tel_down = event.timestamp;
+    _tel_gesture = NONE;
+  }
+
+  if (event.gestureID != _tel_gesture)
+  {
+    int slot = telemetry_gesture_slot(event.gestureID);
+    if (slot >= 0)
+    {
+      _tel_gestures[slot]++;
+    }
+    _tel_gesture = event.gestureID;
+  }
+
+  if (event.event == 1)
+  {
+    if (_tel_touching)
+    {
+      uint32_t ms = (event.timestamp - _tel_down) / 1000;
+      uint8_t bucket = 0;
+      while (bucket < CST816S_DURATION_BUCKETS - 1 && ms >= (50UL << bucket))
+      {
+        bucket++;
+      }
+      _tel_durations[bucket]++;
+      _tel_touches++;
+    }
+    _tel_touching = false;
+    _tel_gesture = NONE;
+  }
+}
+
+/*!
+    @brief  snapshot of the usage and health counters
+
+    Counters run from begin() and never reset; compute rates from the
+    difference between two snapshots and their uptime.
+*/
+touch_telemetry CST816S::telemetry() const
+{
+  touch_telemetry result;
+  result.uptime = cst816s_millis();
+  result.touches = _tel_touches;
+  memcpy(result.gestures, _tel_gestures, sizeof(result.gestures));
+  memcpy(result.durations, _tel_durations, sizeof(result.durations));
+  result.i2c = health();
+  result.irq = irq_status();
+  for (int i = 0; i < POWER_MODE_COUNT; i++)
+  {
+    result.power_time[i] = power_mode_time((POWER_MODE)i);
+  }
+  return result;
+}
+
+/*!
+    @brief  serialize telemetry() into a compact binary record
+
+    The record is 'C', 'T', a format version and then every counter as an
+    LEB128 varint, in touch_telemetry field order (i2c_health and
+    irq_health without the storm flag).
+  @param	buffer
+      destination
+  @param	size
+      capacity, CST816S_TELEMETRY_SIZE always fits
+  @return bytes written, 0 if the buffer is too small
+*/
+size_t CST816S::telemetry_pack(uint8_t *buffer, size_t size) const
+{
+  touch_telemetry t = telemetry();
+  uint32_t fields[CST816S_TELEMETRY_FIELDS];
+  size_t n = 0;
+
+  fields[n++] = t.uptime;
+  fields[n++] = t.touches;
+  for (int i = 0; i < CST816S_TELEMETRY_GESTURES; i++)
+    fields[n++] = t.gestures[i];
+  for (int i = 0; i < CST816S_DURATION_BUCKETS; i++)
+    fields[n++] = t.durations[i];
+  fields[n++] = t.i2c.errors;
+  fields[n++] = t.i2c.retries;
+  fields[n++] = t.i2c.recoveries;
+  fields[n++] = t.i2c.bad_frames;
+  fields[n++] = t.i2c.last_error;
+  fields[n++] = t.irq.irqs;
+  fields[n++] = t.irq.glitches;
+  fields[n++] = t.irq.skipped;
+  fields[n++] = t.irq.storms;
+  for (int i = 0; i < POWER_MODE_COUNT; i++)
+    fields[n++] = t.power_time[i];
+
+  if (size < 3)
+    return 0;
+  size_t pos = 0;
+  buffer[pos++] = 'C';
+  buffer[pos++] = 'T';
+  buffer[pos++] = 1;
+  for (size_t i = 0; i < n; i++)
+  {
+    if (!telemetry_put(buffer, size, pos, fields[i]))
+      return 0;
+  }
+  return pos;
+}
+#endif
+
+/*!
+    @brief  detach a flooding interrupt, and re-arm it after the backoff
+*/
+void CST816S::check_storm()
+{
+  if (_irq < 0 || (!_storm_limit && !_storm))
+  {
+    return;
+  }
+
+  uint32_t now = cst816s_millis();
+  if (_storm)
+  {
+    if (now - _storm_start >= _storm_backoff)
+    {
+      _storm = false;
+      set_polling(_storm_poll_active, _storm_poll_idle);
+      _storm_window = now;
+      _storm_base = _irq_count;
+      cst816s_attach_irq(_irq, isr_trampoline, this, _irq_mode);
+    }
+    return;
+  }
+
+  // Compare the rate rather than the count, so a caller that services the
+  // driver rarely does not mistake normal touch traffic for a storm
+  uint32_t irqs = _irq_count - _storm_base;
+  uint32_t elapsed = now - _storm_window;
+  uint32_t span = elapsed > CST816S_STORM_WINDOW_MS ? elapsed : CST816S_STORM_WINDOW_MS;
+  if (_storm_limit && (uint64_t)irqs * CST816S_STORM_WINDOW_MS > (uint64_t)_storm_limit * span)
+  {
+    cst816s_detach_irq(_irq);
+    _storm = true;
+    _storm_start = now;
+    _storms++;
+    _storm_poll_active = _poll_active;
+    _storm_poll_idle = _poll_idle;
+    set_polling(CST816S_POLL_ACTIVE_US, CST816S_POLL_IDLE_US);
+  }
+  else if (elapsed >= CST816S_STORM_WINDOW_MS)
+  {
+    _storm_window = now;
+    _storm_base = _irq_count;
+  }
+}
+
+/*!
+    @brief  free a stuck bus and reset the controller
+
+    A controller interrupted mid-byte (e.g. by EMI) can hold SDA low
+    forever. Up to nine SCL pulses let it finish the byte, then a STOP
+    releases the bus; custom transports reset their own bus through
+    CST816S_Transport::recover() instead. The controller reset, the wait for
+    it and the configuration restore are left to service_reset(), so a
+    transfer never blocks on them. Skipped in standby,
+    where the controller does not answer by design, and when a recovery
+    ran within the last CST816S_RECOVERY_INTERVAL_MS.
+  @return true if a recovery was performed and the transfer is worth retrying
+*/
+bool CST816S::recover_bus()
+{
+  uint32_t now = cst816s_millis();
+  if (!_recovery || _recovering || _power_mode == POWER_STANDBY ||
+      (_health.recoveries && now - _last_recovery < CST816S_RECOVERY_INTERVAL_MS))
+  {
+    return false;
+  }
+  _recovering = true;
+  _last_recovery = now;
+  _health.recoveries++;
+
+#if CST816S_HAL_ARDUINO
+  if (_wire != nullptr && _sda >= 0 && _scl >= 0)
+  {
+#if CST816S_ESP32
+    _wire->end();
+#endif
+    cst816s_pin_mode(_sda, INPUT_PULLUP);
+    cst816s_pin_mode(_scl, OUTPUT_OPEN_DRAIN);
+    for (int i = 0; i < 9 && !cst816s_digital_read(_sda); i++)
+    {
+      cst816s_digital_write(_scl, LOW);
+      cst816s_delay_us(5);
+      cst816s_digital_write(_scl, HIGH);
+      cst816s_delay_us(5);
+    }
+    // STOP condition: SDA rises while SCL is high
+    cst816s_pin_mode(_sda, OUTPUT_OPEN_DRAIN);
+    cst816s_digital_write(_sda, LOW);
+    cst816s_delay_us(5);
+    cst816s_digital_write(_sda, HIGH);
+    cst816s_delay_us(5);
+    init_bus();
+  }
+  else
+#endif
+  {
+    _transport->recover();
+  }
+
+#if CST816S_RESET_PIN
+  // The reset and the wait for the controller would stall the caller for
+  // up to CST816S_BOOT_TIMEOUT_MS; the next service() runs them instead
+  _reset_state = RESET_PENDING;
+#endif
+
+  _recovering = false;
+  return true;
+}
+
+/*!
+    @brief  advance the controller reset requested by recover_bus()
+
+    Runs from service(), the acquisition task and CST816S_Bus::service().
+    The reset pulse and the wait for the controller are spread over calls,
+    probing like begin_async_poll(), so none of them blocks. Once the
+    controller answers, its configuration is restored from the shadow table.
+  @return true while the reset is in progress; no report is read meanwhile
+*/
+bool CST816S::service_reset()
+{
+  if (_reset_state == RESET_IDLE)
+  {
+    return false;
+  }
+  BUS_GUARD();
+  uint32_t now = cst816s_millis();
+
+  switch (_reset_state)
+  {
+  case RESET_PENDING:
+    if (_power_mode == POWER_STANDBY)
+    {
+      _reset_state = RESET_IDLE;
+      return false;
+    }
+    _config_dirty |= _config_known & config_rewritable;
+    _config_known = 0;
+    pin_write(_rst, LOW);
+    _reset_time = now;
+    _reset_state = RESET_PULSE;
+    break;
+  case RESET_PULSE:
+    if (now - _reset_time >= CST816S_RESET_PULSE_MS)
+    {
+      pin_write(_rst, HIGH);
+      _reset_time = now;
+      _reset_probe = now - CST816S_BOOT_PROBE_MS;
+      _reset_state = RESET_WAIT;
+    }
+    break;
+  case RESET_WAIT:
+    if (now - _reset_probe >= CST816S_BOOT_PROBE_MS)
+    {
+      _reset_probe = now;
+      if (probe())
+      {
+        _reset_state = RESET_IDLE;
+        apply_config();
+        return false;
+      }
+    }
+    if (now - _reset_time >= CST816S_BOOT_TIMEOUT_MS)
+    {
+      // The dirty shadow bytes are written by the next apply_config()
+      _reset_state = RESET_IDLE;
+      return false;
+    }
+    break;
+  default:
+    break;
+  }
+  return true;
+}
+
+/*!
+    @brief  read registers from the controller in a single attempt
+
+    Used where a missing answer is expected, such as probing during boot or
+    polling a controller that may be asleep.
+*/
+uint8_t CST816S::i2c_read_once(uint8_t reg_addr, uint8_t *reg_data, size_t length)
+{
+  BUS_GUARD();
+  uint8_t result = _transport->read(_address, reg_addr, reg_data, length);
+#if CST816S_STATS
+  stats_transfer(result, length);
+#endif
+  return result;
+}
+
+/*!
+    @brief  write registers to the controller in a single attempt
+
+    Used where a missing answer is expected, such as a controller that may
+    be in auto sleep.
+*/
+uint8_t CST816S::i2c_write_once(uint8_t reg_addr, const uint8_t *reg_data, size_t length)
+{
+  BUS_GUARD();
+  uint8_t result = _transport->write(_address, reg_addr, reg_data, length);
+#if CST816S_STATS
+  stats_transfer(result, length);
+#endif
+  return result;
+}
+
+/*!
+    @brief  read data from i2c, with retries and bus recovery
+  @param	addr
+      i2c device address
+  @param	reg_addr
+      device register address
+  @param	reg_data
+      array to copy the read data
+  @param	length
+      length of data
+  @return CST816S_OK or the I2C_RESULT of the last attempt
+*/
+uint8_t CST816S::i2c_read(uint16_t addr, uint8_t reg_addr, uint8_t *reg_data, size_t length)
+{
+  BUS_GUARD();
+  uint8_t result = _transport->read(addr, reg_addr, reg_data, length);
+#if CST816S_STATS
+  stats_transfer(result, length);
+#endif
+  uint32_t backoff = CST816S_I2C_BACKOFF_US;
+  for (uint8_t attempt = 0; result && attempt < _retries; attempt++)
+  {
+    _health.retries++;
+    cst816s_delay_us(backoff);
+    backoff *= 2;
+    result = _transport->read(addr, reg_addr, reg_data, length);
+#if CST816S_STATS
+    stats_transfer(result, length);
+#endif
+  }
+  if (result && recover_bus())
+  {
+    result = _transport->read(addr, reg_addr, reg_data, length);
+  }
+  if (result)
+  {
+    _health.errors++;
+    _health.last_error = result;
+  }
+  return result;
+}
+
+/*!
+    @brief  write data to i2c
+  @param	addr
+      i2c device address
+  @param	reg_addr
+      device register address
+  @param	reg_data
+      data to be sent
+  @param	length
+      length of data
+  @return CST816S_OK or the I2C_RESULT of the last attempt
+*/
+uint8_t CST816S::i2c_write(uint8_t addr, uint8_t reg_addr, const uint8_t *reg_data, size_t length)
+{
+  BUS_GUARD();
+  uint8_t result = _transport->write(addr, reg_addr, reg_data, length);
+#if CST816S_STATS
+  stats_transfer(result, length);
+#endif
+  uint32_t backoff = CST816S_I2C_BACKOFF_US;
+  for (uint8_t attempt = 0; result && attempt < _retries; attempt++)
+  {
+    _health.retries++;
+    cst816s_delay_us(backoff);
+    backoff *= 2;
+    result = _transport->write(addr, reg_addr, reg_data, length);
+#if CST816S_STATS
+    stats_transfer(result, length);
+#endif
+  }
+  if (result && recover_bus())
+  {
+    result = _transport->write(addr, reg_addr, reg_data, length);
+  }
+  if (result)
   {
-    Wire.write(*reg_data++);
+    _health.errors++;
+    _health.last_error = result;
   }
-  if (Wire.endTransmission(true))
-    return -1;
-  return 0;
+  return result;
 }
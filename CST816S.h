@@ -25,10 +25,124 @@
 #ifndef CST816S_H
 #define CST816S_H
 
-#include <Arduino.h>
+#include "CST816S_HAL.h"
+#include <atomic>
+#include <functional>
+
+#include "CST816S_Transport.h"
+
+#if CST816S_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#endif
 
 #define CST816S_ADDRESS     0x15
 
+#define CST816S_I2C_STANDARD_MODE 100000
+#define CST816S_I2C_FAST_MODE     400000   // highest clock the CST816S supports
+
+// Compile-time feature switches. Set them through your build flags (e.g.
+// PlatformIO build_flags) so the library and sketch see the same values.
+#ifndef CST816S_USER_ISR
+#define CST816S_USER_ISR 1       // attachUserInterrupt() support
+#endif
+#ifndef CST816S_GESTURE_NAMES
+#define CST816S_GESTURE_NAMES 1  // gesture() and gesture_name() string tables
+#endif
+#ifndef CST816S_RESET_PIN
+#define CST816S_RESET_PIN 1      // 0 when RST is not wired, skips all reset logic
+#endif
+#ifndef CST816S_FAST_GPIO
+#define CST816S_FAST_GPIO 0      // direct GPIO register access instead of digitalWrite()
+#endif
+#ifndef CST816S_STATS
+#define CST816S_STATS 0          // latency and bus instrumentation, see stats()
+#endif
+#ifndef CST816S_DISPATCH
+#define CST816S_DISPATCH 1       // on_gesture()/on_event() handler tables, see dispatch()
+#endif
+#ifndef CST816S_TELEMETRY
+#define CST816S_TELEMETRY 0      // usage and health counters, see telemetry()
+#endif
+
+// Number of touch samples buffered between the IRQ and the application.
+// Must be a power of two.
+#ifndef CST816S_EVENT_QUEUE_SIZE
+#define CST816S_EVENT_QUEUE_SIZE 16
+#endif
+
+// Number of touch points decoded from each report. The CST816S reports one;
+// some multi-touch CST8xx firmware variants lay out more after it.
+#ifndef CST816S_MAX_POINTS
+#define CST816S_MAX_POINTS 1
+#endif
+
+// Report block: GestureID, FingerNum, then 6 bytes per point
+// (XposH, XposL, YposH, YposL, pressure, area)
+#define CST816S_POINT_SIZE  6
+#define CST816S_REPORT_SIZE (2 + CST816S_POINT_SIZE * CST816S_MAX_POINTS)
+
+// Configuration registers MotionMask (0xEC) .. DisAutoSleep (0xFE) are
+// contiguous and cached in a shadow table (see apply_config())
+#define CST816S_CONFIG_FIRST 0xEC
+#define CST816S_CONFIG_LAST  0xFE
+#define CST816S_CONFIG_SIZE  (CST816S_CONFIG_LAST - CST816S_CONFIG_FIRST + 1)
+
+// Fast boot (see begin_fast()/begin_async())
+#ifndef CST816S_RESET_PULSE_MS
+#define CST816S_RESET_PULSE_MS 5
+#endif
+#ifndef CST816S_BOOT_TIMEOUT_MS
+#define CST816S_BOOT_TIMEOUT_MS 100
+#endif
+#ifndef CST816S_BOOT_PROBE_MS
+#define CST816S_BOOT_PROBE_MS 2     // chip ID probe interval of begin_async_poll()
+#endif
+
+// Adaptive polling for boards without an IRQ line (see set_polling())
+#ifndef CST816S_POLL_ACTIVE_US
+#define CST816S_POLL_ACTIVE_US 10000    // 100 Hz while a finger is down
+#endif
+#ifndef CST816S_POLL_IDLE_US
+#define CST816S_POLL_IDLE_US   100000   // backs off to 10 Hz when idle
+#endif
+
+// Bus error handling (see set_retries())
+#ifndef CST816S_I2C_RETRIES
+#define CST816S_I2C_RETRIES 2              // extra attempts per failed transfer
+#endif
+#ifndef CST816S_I2C_BACKOFF_US
+#define CST816S_I2C_BACKOFF_US 100         // wait before the first retry, doubles per retry
+#endif
+#ifndef CST816S_RECOVERY_INTERVAL_MS
+#define CST816S_RECOVERY_INTERVAL_MS 100   // minimum time between bus recoveries
+#endif
+
+// Interrupt storm protection (see set_storm_protection())
+#ifndef CST816S_STORM_IRQS
+#define CST816S_STORM_IRQS 100          // interrupts per window treated as a storm, 0 = off
+#endif
+#ifndef CST816S_STORM_WINDOW_MS
+#define CST816S_STORM_WINDOW_MS 100
+#endif
+#ifndef CST816S_STORM_BACKOFF_MS
+#define CST816S_STORM_BACKOFF_MS 1000   // time spent polling before the interrupt is re-armed
+#endif
+
+#if CST816S_ESP32
+// Background acquisition task defaults (see begin_task())
+#ifndef CST816S_TASK_STACK_SIZE
+#define CST816S_TASK_STACK_SIZE 2048
+#endif
+#ifndef CST816S_TASK_PRIORITY
+#define CST816S_TASK_PRIORITY 5
+#endif
+#ifndef CST816S_TASK_CORE
+#define CST816S_TASK_CORE 0
+#endif
+#endif
+
 enum GESTURE {
   NONE = 0x00,
   SWIPE_UP = 0x01,
@@ -41,14 +155,180 @@ enum GESTURE {
 
 };
 
+enum BOOT_STATE {
+  BOOT_IDLE = 0,
+  BOOT_RESET,    // reset pulse in progress
+  BOOT_WAIT,     // polling for the controller to answer
+  BOOT_READY,
+  BOOT_TIMEOUT
+};
+
+enum POWER_MODE {
+  POWER_ACTIVE = 0,         // all gestures, auto sleep enabled
+  POWER_LOW_LATENCY,        // no double-tap wait, auto sleep disabled
+  POWER_IDLE_GESTURE_ONLY,  // IRQ on double-tap only, auto sleep enabled
+  POWER_STANDBY,            // deep sleep, woken by a reset
+  POWER_MODE_COUNT
+};
+
+struct touch_point {
+  uint8_t event; // Event (0 = Down, 1 = Up, 2 = Contact)
+  uint8_t id;    // Touch ID
+  int x;
+  int y;
+  uint8_t pressure; // Not reported by all firmware variants (reads 0)
+  uint8_t area;     // Not reported by all firmware variants (reads 0)
+};
+
 struct data_struct {
-  byte gestureID; // Gesture ID
-  byte points;  // Number of touch points
-  byte event; // Event (0 = Down, 1 = Up, 2 = Contact)
+  uint8_t gestureID; // Gesture ID
+  uint8_t points;  // Number of touch points
+  uint8_t event; // Event (0 = Down, 1 = Up, 2 = Contact)
   int x;
   int y;
   uint8_t version;
   uint8_t versionInfo[3];
+  touch_point point[CST816S_MAX_POINTS]; // point[0] mirrors event/x/y
+};
+
+struct touch_event {
+  uint32_t timestamp; // micros() at the IRQ that produced this sample
+  uint8_t gestureID;
+  uint8_t points;
+  uint8_t event;
+  int x;
+  int y;
+  touch_point point[CST816S_MAX_POINTS];
+};
+
+#if CST816S_STATS
+#define CST816S_LATENCY_BUCKETS 64
+
+struct touch_stats {
+  uint32_t events;       // samples consumed by the application
+  uint32_t latency_min;  // IRQ to consume, in us
+  uint32_t latency_avg;
+  uint32_t latency_max;
+  uint32_t latency_p99;  // upper bound of the 99th percentile histogram bucket
+  uint32_t reads;        // touch report reads
+  uint32_t read_min;     // I2C report read time, in us
+  uint32_t read_avg;
+  uint32_t read_max;
+  uint32_t irqs;         // interrupts received
+  uint32_t missed_irqs;  // interrupts merged into an earlier unread report
+  uint32_t nacks;        // failed I2C transactions
+  uint32_t bytes;        // register bytes transferred
+};
+#endif
+
+enum CHIP_VARIANT {
+  CHIP_UNKNOWN = 0,
+  CHIP_CST816S,
+  CHIP_CST816T,
+  CHIP_CST816D,
+  CHIP_CST820,
+  CHIP_CST716
+};
+
+struct i2c_health {
+  uint32_t errors;      // transfers that failed after all retries
+  uint32_t retries;     // repeated transfer attempts
+  uint32_t recoveries;  // bus recoveries (SCL clock-out and controller reset)
+  uint32_t bad_frames;  // touch reports rejected by validation
+  uint8_t last_error;   // I2C_RESULT of the most recent failure
+};
+
+struct irq_health {
+  uint32_t irqs;      // interrupts received
+  uint32_t glitches;  // interrupts ignored by the level check
+  uint32_t skipped;   // full report reads avoided by the finger-count precheck
+  uint32_t storms;    // times the interrupt was detached for flooding
+  bool storm;         // true while polling in place of the interrupt
+};
+
+#if CST816S_TELEMETRY
+#define CST816S_TELEMETRY_GESTURES 7   // SWIPE_UP..SINGLE_CLICK, DOUBLE_CLICK, LONG_PRESS
+#define CST816S_DURATION_BUCKETS   8   // < 50 ms, then doubling up to >= 3.2 s
+#define CST816S_TELEMETRY_FIELDS   (2 + CST816S_TELEMETRY_GESTURES + CST816S_DURATION_BUCKETS + 9 + POWER_MODE_COUNT)
+#define CST816S_TELEMETRY_SIZE     (3 + 5 * CST816S_TELEMETRY_FIELDS)  // worst case of telemetry_pack()
+
+struct touch_telemetry {
+  uint32_t uptime;                                // ms since boot
+  uint32_t touches;                               // completed touches
+  uint32_t gestures[CST816S_TELEMETRY_GESTURES];  // gestures reported by the controller
+  uint32_t durations[CST816S_DURATION_BUCKETS];   // touch down to up histogram
+  i2c_health i2c;
+  irq_health irq;
+  uint32_t power_time[POWER_MODE_COUNT];          // ms in each power mode
+};
+#endif
+
+struct cst816s_chip;
+class CST816S_Predictor;
+class CST816S_Transform;
+class CST816S_Filter;
+class CST816S_Recorder;
+
+typedef std::function<void(const touch_event &)> touch_event_callback;
+
+// Handler table sizes: one slot per GestureID code (0x00-0x0C) and per
+// event code (0 = down, 1 = up, 2 = contact)
+#define CST816S_GESTURE_SLOTS (LONG_PRESS + 1)
+#define CST816S_EVENT_SLOTS   3
+
+/*!
+    @brief  Fixed-size single-producer/single-consumer lock-free queue.
+
+    One context may push() and one other context may pop() concurrently
+    without a lock. Indices run freely and are masked on access, so all N
+    slots are usable.
+*/
+template <typename T, size_t N>
+class CST816S_Queue {
+  static_assert(N != 0 && (N & (N - 1)) == 0, "queue size must be a power of two");
+
+  public:
+    bool push(const T &item)
+    {
+      uint32_t head = _head.load(std::memory_order_relaxed);
+      if (head - _tail.load(std::memory_order_acquire) >= N) {
+        return false;
+      }
+      _items[head & (N - 1)] = item;
+      _head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool pop(T &item)
+    {
+      uint32_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _head.load(std::memory_order_acquire)) {
+        return false;
+      }
+      item = _items[tail & (N - 1)];
+      _tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool peek(T &item) const
+    {
+      uint32_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _head.load(std::memory_order_acquire)) {
+        return false;
+      }
+      item = _items[tail & (N - 1)];
+      return true;
+    }
+
+    size_t size() const
+    {
+      return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+  private:
+    T _items[N];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
 };
 
 
@@ -56,8 +336,19 @@ struct data_struct {
 class CST816S {
 
   public:
+#if CST816S_HAL_ARDUINO
     CST816S(int sda, int scl, int rst, int irq);
-    void begin(int interrupt = RISING);
+    CST816S(int sda, int scl, int rst, int irq, TwoWire &wire, uint32_t clock = 0);
+#endif
+    CST816S(int rst, int irq, CST816S_Transport &transport);
+    void begin(int interrupt = CST816S_RISING);
+    bool begin_fast(int interrupt = CST816S_RISING, uint32_t timeout = CST816S_BOOT_TIMEOUT_MS);
+    void begin_async(int interrupt = CST816S_RISING, uint32_t timeout = CST816S_BOOT_TIMEOUT_MS);
+    BOOT_STATE begin_async_poll();
+#if CST816S_ESP32
+    bool begin_task(int interrupt = CST816S_RISING, BaseType_t core = CST816S_TASK_CORE,
+                    UBaseType_t priority = CST816S_TASK_PRIORITY);
+#endif
     void enable_double_click();              //!< @brief Enable double-tap gesture detection
     void enable_double_click_interrupt_only(); //!< @brief Wrapper: set motion mask & irq control for double-tap only
     /** @brief Directly program the MotionMask register (0xEC). */
@@ -67,25 +358,238 @@ class CST816S {
     void disable_auto_sleep();
     void enable_auto_sleep();
     void set_auto_sleep_time(int seconds);
-    void attachUserInterrupt(std::function<void(void)> callback);
+    void begin_config();
+    uint8_t apply_config();
+    uint8_t load_config();
+    uint8_t read_registers(uint8_t reg, uint8_t *values, size_t length);
+    uint8_t write_registers(uint8_t reg, const uint8_t *values, size_t length);
+#if CST816S_USER_ISR
+    void attachUserInterrupt(void (*callback)(void));
+    void attachUserInterrupt(void (*callback)(void *), void *arg);
+#endif
     void sleep();
+    bool set_power_mode(POWER_MODE mode);
+    POWER_MODE power_mode() const;
+    uint32_t power_mode_time(POWER_MODE mode) const;
+#if CST816S_ESP32
+    bool prepare_sleep(bool deep = true);
+    bool resume(int interrupt = CST816S_RISING);
+#endif
     bool available();
+    data_struct snapshot() const;
+    void service();
+    bool pop(touch_event &event);
+    bool pop_queued(touch_event &event);
+    size_t read_events(touch_event *events, size_t max);
+    size_t events_pending() const;
+    void inject_interrupt();
+    void set_min_interval(uint32_t us);
+    void set_min_delta(int pixels);
+    void set_coalescing(bool enable);
+    void set_predictor(CST816S_Predictor *predictor);
+    void set_transform(CST816S_Transform *transform);
+    void set_filter(CST816S_Filter *filter);
+    void set_recorder(CST816S_Recorder *recorder);
+    void set_polling(uint32_t active_us, uint32_t idle_us);
+    void set_address(uint8_t address);
+    CHIP_VARIANT chip() const;
+    void set_chip(CHIP_VARIANT variant);
+#if CST816S_STATS
+    touch_stats stats() const;
+    void reset_stats();
+#endif
+#if CST816S_DISPATCH
+    void on_gesture(GESTURE gesture, touch_event_callback handler);
+    void on_event(uint8_t event, touch_event_callback handler);
+    size_t dispatch(size_t max = 0);
+#endif
+    bool read_async(touch_event_callback callback = nullptr);
+    bool read_async_done(touch_event &event);
+    uint8_t read_async_error();
+    uint32_t dropped_events() const;
+    void set_retries(uint8_t retries, bool recovery = true);
+    i2c_health health() const;
+    void set_irq_check(bool level, bool precheck);
+    void set_storm_protection(uint32_t max_irqs, uint32_t backoff_ms = CST816S_STORM_BACKOFF_MS);
+    irq_health irq_status() const;
+#if CST816S_TELEMETRY
+    touch_telemetry telemetry() const;
+    size_t telemetry_pack(uint8_t *buffer, size_t size) const;
+#endif
     data_struct data;
+#if CST816S_GESTURE_NAMES
+#if CST816S_HAL_ARDUINO
     String gesture();
+#endif
+    static const char *gesture_name(GESTURE gesture);
+    static size_t gesture_name(GESTURE gesture, char *buffer, size_t size);
+#endif
 
 
   private:
+    friend class CST816S_Bus;
+
     int _sda;
     int _scl;
     int _rst;
     int _irq;
-    bool _event_available;
-    std::function<void(void)> userISR;
+    uint8_t _address = CST816S_ADDRESS;
+    const cst816s_chip *_chip;
+    TwoWire *_wire;
+#if CST816S_HAL_ARDUINO
+    CST816S_WireTransport _wire_transport;
+#endif
+    CST816S_Transport *_transport;
+    uint32_t _clock;
+    volatile bool _event_available = false;
+    volatile uint32_t _irq_time = 0;
+    volatile uint32_t _irq_count = 0;
+    volatile uint32_t _irq_glitches = 0;
+    int _irq_mode = CST816S_RISING;
+    int8_t _irq_level = -1;              // level expected in the ISR, -1 = no check
+    bool _irq_check_level = false;
+    bool _precheck = false;
+    bool _precheck_touching = false;
+    uint32_t _precheck_skipped = 0;
+    uint32_t _storm_limit = CST816S_STORM_IRQS;
+    uint32_t _storm_backoff = CST816S_STORM_BACKOFF_MS;
+    uint32_t _storm_window = 0;
+    uint32_t _storm_base = 0;
+    uint32_t _storm_start = 0;
+    uint32_t _storms = 0;
+    bool _storm = false;
+    uint32_t _storm_poll_active = 0;     // polling settings to restore after a storm
+    uint32_t _storm_poll_idle = 0;
+    volatile uint32_t _dropped = 0;
+    CST816S_Queue<touch_event, CST816S_EVENT_QUEUE_SIZE> _events;
+    std::atomic<uint32_t> _data_seq{0};  // seqlock guarding data, see snapshot()
+    uint8_t _retries = CST816S_I2C_RETRIES;
+    bool _recovery = true;
+    bool _recovering = false;
+    uint32_t _last_recovery = 0;
+    enum reset_state : uint8_t { RESET_IDLE, RESET_PENDING, RESET_PULSE, RESET_WAIT };
+    reset_state _reset_state = RESET_IDLE;  // controller reset deferred by recover_bus()
+    uint32_t _reset_time = 0;
+    uint32_t _reset_probe = 0;
+    i2c_health _health = {};
+
+    uint32_t _min_interval = 0;
+    int _min_delta = 0;
+    bool _coalesce = false;
+    CST816S_Predictor *_predictor = nullptr;
+    CST816S_Transform *_transform = nullptr;
+    CST816S_Filter *_filter = nullptr;
+    CST816S_Recorder *_recorder = nullptr;
+
+    uint32_t _poll_active = 0;   // 0 = interrupt driven
+    uint32_t _poll_idle = 0;
+    uint32_t _poll_interval = 0;
+    uint32_t _poll_last = 0;
+    bool _poll_touching = false;
+    uint32_t _last_read = 0;
+    int _last_x = -1;
+    int _last_y = -1;
+    uint8_t _last_gesture = NONE;      // gesture of the last queued sample
+    uint8_t _coalesce_gesture = NONE;  // gesture of the last delivered sample
+
+    POWER_MODE _power_mode = POWER_ACTIVE;
+    uint32_t _power_since = 0;
+    uint32_t _power_time[POWER_MODE_COUNT] = {};
+
+    BOOT_STATE _boot_state = BOOT_IDLE;
+    int _boot_interrupt;
+    uint32_t _boot_start;
+    uint32_t _boot_probe;
+    uint32_t _boot_timeout;
+
+    uint8_t _config[CST816S_CONFIG_SIZE];
+    uint32_t _config_known = 0;  // shadow bytes that match the chip
+    uint32_t _config_dirty = 0;  // shadow bytes still to be written
+    bool _config_batch = false;
+
+#if CST816S_STATS
+    volatile uint32_t _stat_irqs = 0;
+    volatile uint32_t _stat_missed = 0;
+    uint32_t _stat_events = 0;
+    uint32_t _stat_latency_min = UINT32_MAX;
+    uint32_t _stat_latency_max = 0;
+    uint64_t _stat_latency_sum = 0;
+    uint32_t _stat_latency_hist[CST816S_LATENCY_BUCKETS] = {};
+    uint32_t _stat_reads = 0;
+    uint32_t _stat_read_min = UINT32_MAX;
+    uint32_t _stat_read_max = 0;
+    uint64_t _stat_read_sum = 0;
+    uint32_t _stat_nacks = 0;
+    uint32_t _stat_bytes = 0;
+
+    void stats_consume(const touch_event &event);
+    void stats_read(uint32_t start);
+    void stats_transfer(uint8_t result, size_t length);
+#endif
+
+#if CST816S_TELEMETRY
+    uint32_t _tel_touches = 0;
+    uint32_t _tel_gestures[CST816S_TELEMETRY_GESTURES] = {};
+    uint32_t _tel_durations[CST816S_DURATION_BUCKETS] = {};
+    uint32_t _tel_down = 0;
+    bool _tel_touching = false;
+    uint8_t _tel_gesture = NONE;
+
+    void telemetry_sample(const touch_event &event);
+#endif
+
+    enum async_state : uint8_t { ASYNC_IDLE, ASYNC_PENDING, ASYNC_DONE, ASYNC_ERROR };
+    std::atomic<uint8_t> _async_state{ASYNC_IDLE};
+    touch_event _async_result;
+    uint8_t _async_error = CST816S_OK;
+    touch_event_callback _async_callback;
+#if CST816S_DISPATCH
+    touch_event_callback _gesture_handlers[CST816S_GESTURE_SLOTS];
+    touch_event_callback _event_handlers[CST816S_EVENT_SLOTS];
+    uint8_t _dispatch_gesture = NONE;
+#endif
+#if CST816S_USER_ISR
+    void (*userISR)(void) = nullptr;
+    void (*userISRArg)(void *) = nullptr;
+    void *userArg = nullptr;
+#endif
+#if CST816S_ESP32
+    TaskHandle_t _task = nullptr;
+    SemaphoreHandle_t _bus_lock = nullptr;  // register access vs. the task, see begin_task()
+
+    static void task_loop(void *arg);
+    TickType_t task_wait() const;
+    void task_step();
+#endif
 
 
+    static void IRAM_ATTR isr_trampoline(void *arg);
     void IRAM_ATTR handleISR();
-    void read_touch();
+    void capture();
+    void queue_sample(touch_event &event);
+    void acquire();
+    void poll_controller();
+    void attach_irq(int interrupt);
+    void detect_chip();
+    void update_irq_level();
+    void check_storm();
+    void enter_power_mode(POWER_MODE mode);
+    bool next_event(touch_event &event);
+    void init_io();
+    void init_bus();
+    bool recover_bus();
+    bool service_reset();
+    void reset_pulse();
+    bool probe();
+    bool wait_ready(uint32_t timeout);
+    void finish_begin(int interrupt, bool ready);
+    void complete_async();
+    void config_write(uint8_t reg, uint8_t value);
+    void config_update(uint8_t reg, const uint8_t *values, size_t length);
+    uint8_t read_touch(touch_event &event);
 
+    uint8_t i2c_read_once(uint8_t reg_addr, uint8_t *reg_data, size_t length);
+    uint8_t i2c_write_once(uint8_t reg_addr, const uint8_t *reg_data, size_t length);
     uint8_t i2c_read(uint16_t addr, uint8_t reg_addr, uint8_t * reg_data, size_t length);
     uint8_t i2c_write(uint8_t addr, uint8_t reg_addr, const uint8_t * reg_data, size_t length);
 };
@@ -0,0 +1,158 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CST816S_Bus.h"
+
+/*!
+    @brief  register a controller, after its begin()
+
+    May be called while the shared task runs: the list is changed under the
+    bus mutex, which the task holds while it walks the controllers.
+  @param	touch
+      controller to service, must not run its own acquisition task
+  @return false if CST816S_BUS_MAX_DEVICES controllers are already registered
+*/
+bool CST816S_Bus::add(CST816S &touch)
+{
+#if CST816S_ESP32
+  if (_lock != nullptr)
+  {
+    xSemaphoreTakeRecursive(_lock, portMAX_DELAY);
+  }
+#endif
+  bool added = _count < CST816S_BUS_MAX_DEVICES;
+  if (added)
+  {
+#if CST816S_ESP32
+    // Route the controller's interrupt to the shared task
+    if (_task != nullptr)
+    {
+      touch._bus_lock = _lock;
+      touch._task = _task;
+    }
+#endif
+    _devices[_count++] = &touch;
+  }
+#if CST816S_ESP32
+  if (_lock != nullptr)
+  {
+    xSemaphoreGiveRecursive(_lock);
+  }
+#endif
+  return added;
+}
+
+/*!
+    @brief  read the pending reports of all controllers back to back
+
+    Call this from your loop when the shared task is not used.
+*/
+void CST816S_Bus::service()
+{
+#if CST816S_ESP32
+  if (_task != nullptr)
+  {
+    return;
+  }
+#endif
+  for (size_t i = 0; i < _count; i++)
+  {
+    _devices[i]->acquire();
+  }
+}
+
+#if CST816S_ESP32
+/*!
+    @brief  start one acquisition task shared by all registered controllers
+
+    Any controller's interrupt wakes the task, which then reads every
+    pending report in one pass. The controllers share one bus mutex with
+    the task, since they may sit on the same I2C bus, so register access
+    from loop() on any of them waits for the task's current read.
+  @param	core
+      core to pin the task to
+  @param	priority
+      FreeRTOS priority of the task
+  @return true if the task was created
+*/
+bool CST816S_Bus::begin_task(BaseType_t core, UBaseType_t priority)
+{
+  if (_task != nullptr)
+  {
+    return true;
+  }
+  if (_lock == nullptr)
+  {
+    _lock = xSemaphoreCreateRecursiveMutex();
+    if (_lock == nullptr)
+    {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < _count; i++)
+  {
+    _devices[i]->_bus_lock = _lock;
+  }
+  if (xTaskCreatePinnedToCore(task_loop, "cst816s_bus", CST816S_TASK_STACK_SIZE, this,
+                              priority, &_task, core) != pdPASS)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < _count; i++)
+  {
+    _devices[i]->_task = _task;
+  }
+  return true;
+}
+
+/*!
+    @brief  body of the shared acquisition task
+*/
+void CST816S_Bus::task_loop(void *arg)
+{
+  CST816S_Bus *bus = static_cast<CST816S_Bus *>(arg);
+  for (;;)
+  {
+    // The controller list is only walked under the bus mutex, so add()
+    // cannot change it mid-pass
+    TickType_t wait = portMAX_DELAY;
+    xSemaphoreTakeRecursive(bus->_lock, portMAX_DELAY);
+    for (size_t i = 0; i < bus->_count; i++)
+    {
+      TickType_t device_wait = bus->_devices[i]->task_wait();
+      wait = device_wait < wait ? device_wait : wait;
+    }
+    xSemaphoreGiveRecursive(bus->_lock);
+
+    ulTaskNotifyTake(pdTRUE, wait);
+
+    xSemaphoreTakeRecursive(bus->_lock, portMAX_DELAY);
+    for (size_t i = 0; i < bus->_count; i++)
+    {
+      bus->_devices[i]->task_step();
+    }
+    xSemaphoreGiveRecursive(bus->_lock);
+  }
+}
+#endif
@@ -0,0 +1,62 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_BUS_H
+#define CST816S_BUS_H
+
+#include "CST816S.h"
+
+#ifndef CST816S_BUS_MAX_DEVICES
+#define CST816S_BUS_MAX_DEVICES 4
+#endif
+
+/*!
+    @brief  Services several CST816S instances together
+
+    Pending reports of all registered controllers are read back to back in
+    one pass, instead of each instance being serviced through its own
+    blocking call or task. Controllers may sit on separate buses, share one
+    (with different addresses, see set_address()) or sit behind a
+    multiplexer (see CST816S_MuxTransport).
+*/
+class CST816S_Bus {
+  public:
+    bool add(CST816S &touch);
+    void service();
+#if CST816S_ESP32
+    bool begin_task(BaseType_t core = CST816S_TASK_CORE, UBaseType_t priority = CST816S_TASK_PRIORITY);
+#endif
+
+  private:
+    CST816S *_devices[CST816S_BUS_MAX_DEVICES];
+    size_t _count = 0;
+#if CST816S_ESP32
+    TaskHandle_t _task = nullptr;
+    SemaphoreHandle_t _lock = nullptr;  // shared by all registered controllers
+
+    static void task_loop(void *arg);
+#endif
+};
+
+#endif
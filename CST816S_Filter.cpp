@@ -0,0 +1,285 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CST816S_Filter.h"
+
+static int median3(int a, int b, int c)
+{
+  if (a > b)
+  {
+    int t = a;
+    a = b;
+    b = t;
+  }
+  // a <= b, the median is b clamped to [a, c] or c itself
+  return c < a ? a : (c > b ? b : c);
+}
+
+/*!
+    @brief  Constructor for CST816S_Filter, every stage starts disabled
+*/
+CST816S_Filter::CST816S_Filter()
+{
+  reset();
+}
+
+/*!
+    @brief  enable the median of three stage
+  @param	enable
+      true to replace x/y with the median of the last three measurements
+*/
+void CST816S_Filter::set_median(bool enable)
+{
+  _median = enable;
+}
+
+/*!
+    @brief  set the exponential smoothing gain
+  @param	alpha
+      weight of a new measurement in 1/256 units, lower smooths more, 0 disables
+*/
+void CST816S_Filter::set_smoothing(uint8_t alpha)
+{
+  _alpha = alpha;
+}
+
+/*!
+    @brief  set the minimum contact time for a touch to be reported
+  @param	min_contact_us
+      touches released earlier are dropped entirely, 0 disables
+*/
+void CST816S_Filter::set_debounce(uint32_t min_contact_us)
+{
+  _debounce = min_contact_us;
+}
+
+/*!
+    @brief  reject implausible jumps between consecutive contact samples
+  @param	pixels
+      largest movement on either axis accepted between two samples, 0 disables
+  @param	max_rejects
+      consecutive jumps dropped before the new position is taken as real
+*/
+void CST816S_Filter::set_max_jump(int pixels, uint8_t max_rejects)
+{
+  _max_jump = pixels;
+  _max_rejects = max_rejects;
+}
+
+/*!
+    @brief  filter one sample in place
+
+    While the debounce holds a touch back, its samples are dropped; the first
+    sample after the minimum contact time is delivered as the touch down. If
+    that sample is the release, call release() for it after the touch down.
+    Samples carrying a controller gesture are never dropped.
+  @param	event
+      sample to update in place
+  @return true to deliver the sample, false to drop it
+*/
+bool CST816S_Filter::apply(touch_event &event)
+{
+  bool gesture = event.gestureID != NONE;
+  _released = false;
+
+  // Event: 0 = Down, 1 = Up, 2 = Contact
+  if (event.event == 0 || (!_active && !_pending))
+  {
+    restart(event.x, event.y);
+    _down_time = event.timestamp;
+    if (event.event == 1)
+    {
+      return true;  // release of a touch the filter never saw
+    }
+    if (_debounce && !gesture)
+    {
+      _pending = true;
+      _active = false;
+      return false;
+    }
+    _pending = false;
+    _active = true;
+    event.event = 0;
+    smooth(event);
+    return true;
+  }
+
+  if (_pending)
+  {
+    if (!gesture && event.timestamp - _down_time < _debounce)
+    {
+      if (event.event == 1)
+      {
+        _pending = false;
+        _rejected_touches++;
+      }
+      else
+      {
+        restart(event.x, event.y);
+      }
+      return false;
+    }
+    // Long enough: this sample becomes the touch down the application sees
+    _pending = false;
+    restart(event.x, event.y);
+    if (event.event == 1)
+    {
+      // Held without contact samples: deliver a touch down now, the
+      // release follows from release()
+      _release = event;
+      _released = true;
+      event.gestureID = NONE;
+      if (event.points == 0)
+      {
+        event.points = 1;
+      }
+      event.point[0].event = 0;
+    }
+    else
+    {
+      _active = true;
+    }
+    event.event = 0;
+    smooth(event);
+    return true;
+  }
+
+  if (event.event == 2 && _max_jump && !gesture &&
+      (abs(event.x - _last_x) > _max_jump || abs(event.y - _last_y) > _max_jump))
+  {
+    if (_jumps < _max_rejects)
+    {
+      _jumps++;
+      _rejected_samples++;
+      return false;
+    }
+    // The jump persisted, so the finger really is there
+    restart(event.x, event.y);
+  }
+  _jumps = 0;
+
+  _active = event.event != 1;
+  smooth(event);
+  return true;
+}
+
+/*!
+    @brief  take the release held back by the last apply()
+
+    Set when a debounced touch had no contact samples after the minimum
+    contact time, so apply() turned its release into the touch down.
+  @param	event
+      receives the release
+  @return true if there was one
+*/
+bool CST816S_Filter::release(touch_event &event)
+{
+  if (!_released)
+  {
+    return false;
+  }
+  _released = false;
+  event = _release;
+  return true;
+}
+
+/*!
+    @brief  forget the current touch, the next sample starts afresh
+*/
+void CST816S_Filter::reset()
+{
+  _active = false;
+  _pending = false;
+  _released = false;
+  _jumps = 0;
+  _count = 0;
+  _next = 0;
+}
+
+/*!
+    @brief  touches dropped by the debounce
+*/
+uint32_t CST816S_Filter::rejected_touches() const
+{
+  return _rejected_touches;
+}
+
+/*!
+    @brief  contact samples dropped as implausible jumps
+*/
+uint32_t CST816S_Filter::rejected_samples() const
+{
+  return _rejected_samples;
+}
+
+/*!
+    @brief  clear the history and seed the filters at a position
+*/
+void CST816S_Filter::restart(int x, int y)
+{
+  _count = 0;
+  _next = 0;
+  _jumps = 0;
+  _sx = (int32_t)x << 8;
+  _sy = (int32_t)y << 8;
+}
+
+/*!
+    @brief  run the median and exponential stages on x/y
+*/
+void CST816S_Filter::smooth(touch_event &event)
+{
+  _last_x = event.x;
+  _last_y = event.y;
+
+  int x = event.x;
+  int y = event.y;
+
+  if (_median)
+  {
+    _hx[_next] = x;
+    _hy[_next] = y;
+    _next = _next == 2 ? 0 : _next + 1;
+    if (_count < 3)
+    {
+      _count++;
+    }
+    if (_count == 3)
+    {
+      x = median3(_hx[0], _hx[1], _hx[2]);
+      y = median3(_hy[0], _hy[1], _hy[2]);
+    }
+  }
+
+  if (_alpha)
+  {
+    _sx += (_alpha * (((int32_t)x << 8) - _sx)) >> 8;
+    _sy += (_alpha * (((int32_t)y << 8) - _sy)) >> 8;
+    x = (_sx + 128) >> 8;
+    y = (_sy + 128) >> 8;
+  }
+
+  event.x = x;
+  event.y = y;
+}
@@ -0,0 +1,83 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_FILTER_H
+#define CST816S_FILTER_H
+
+#include "CST816S.h"
+
+/*!
+    @brief  Noise rejection and smoothing stage for touch samples
+
+    Holds back touch down until the contact has lasted a minimum time, drops
+    isolated samples that jump further than a finger can move between two
+    reports, and smooths x/y with a median of three and/or a Q8 exponential
+    filter. Fixed-size state, integer math only. point[0] keeps the measured
+    coordinates. Attach it with CST816S::set_filter().
+*/
+class CST816S_Filter {
+  public:
+    CST816S_Filter();
+    void set_median(bool enable);
+    void set_smoothing(uint8_t alpha);
+    void set_debounce(uint32_t min_contact_us);
+    void set_max_jump(int pixels, uint8_t max_rejects = 2);
+    bool apply(touch_event &event);
+    bool release(touch_event &event);
+    void reset();
+
+    uint32_t rejected_touches() const;
+    uint32_t rejected_samples() const;
+
+  private:
+    bool _median = false;
+    int32_t _alpha = 0;        // smoothing gain, Q8, 0 = off
+    uint32_t _debounce = 0;    // minimum contact time, us
+    int _max_jump = 0;         // px per sample, 0 = off
+    uint8_t _max_rejects = 2;  // consecutive jumps dropped before accepting
+
+    bool _active = false;      // touch down delivered
+    bool _pending = false;     // touch down held back by the debounce
+    bool _released = false;    // _release follows the delivered touch down
+    touch_event _release;
+    uint32_t _down_time = 0;
+    uint8_t _jumps = 0;
+    int _last_x = 0;           // last accepted measurement
+    int _last_y = 0;
+
+    int _hx[3];                // median history
+    int _hy[3];
+    uint8_t _count = 0;
+    uint8_t _next = 0;
+    int32_t _sx = 0;           // smoothed position, Q8 px
+    int32_t _sy = 0;
+
+    uint32_t _rejected_touches = 0;
+    uint32_t _rejected_samples = 0;
+
+    void restart(int x, int y);
+    void smooth(touch_event &event);
+};
+
+#endif
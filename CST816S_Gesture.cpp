@@ -0,0 +1,285 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CST816S_Gesture.h"
+
+/*!
+    @brief  set the maximum movement for a touch to still count as a tap
+  @param	pixels
+      slop radius, movement beyond it starts a drag
+*/
+void CST816S_Gesture::set_tap_slop(int pixels)
+{
+  _tap_slop = pixels;
+}
+
+/*!
+    @brief  set the minimum travel for a swipe
+  @param	pixels
+      distance along the dominant axis
+*/
+void CST816S_Gesture::set_swipe_distance(int pixels)
+{
+  _swipe_distance = pixels;
+}
+
+/*!
+    @brief  set the minimum speed for a swipe, slower movement is a drag
+  @param	pixels_per_second
+      speed along the dominant axis
+*/
+void CST816S_Gesture::set_swipe_velocity(int pixels_per_second)
+{
+  _swipe_velocity = pixels_per_second;
+}
+
+/*!
+    @brief  set how long a stationary touch must be held for a long press
+  @param	ms
+      hold time in milliseconds
+*/
+void CST816S_Gesture::set_long_press_time(uint32_t ms)
+{
+  _long_press_time = ms * 1000;
+}
+
+/*!
+    @brief  set the maximum time between two taps of a double tap
+  @param	ms
+      window in milliseconds, 0 disables double taps so single taps are
+      reported immediately on release
+*/
+void CST816S_Gesture::set_double_tap_window(uint32_t ms)
+{
+  _double_tap_window = ms * 1000;
+}
+
+/*!
+    @brief  feed one touch sample
+  @param	event
+      sample from pop(), read_events() or the acquisition task
+  @param	result
+      receives the recognized gesture or drag update
+  @return true if result was filled
+*/
+bool CST816S_Gesture::update(const touch_event &event, gesture_event &result)
+{
+  // Event: 0 = Down, 1 = Up, 2 = Contact
+  if (event.event == 0 || (event.event == 2 && !_touching))
+  {
+    touch_down(event);
+    if (!_tap_pending)
+    {
+      return false;
+    }
+
+    _tap_pending = false;
+    if (event.timestamp - _tap_time <= _double_tap_window &&
+        abs(_x - _tap_x) <= 2 * _tap_slop && abs(_y - _tap_y) <= 2 * _tap_slop)
+    {
+      _reported = true;
+      fill(result, DOUBLE_CLICK);
+      return true;
+    }
+    // Too late or too far for a double tap: the pending tap is reported now,
+    // before anything this touch produces
+    fill_tap(result);
+    return true;
+  }
+
+  if (!_touching)
+  {
+    return false;
+  }
+  track(event);
+
+  if (event.event == 1)
+  {
+    _touching = false;
+    if (_reported)
+    {
+      return false;
+    }
+    if (_moved)
+    {
+      // A short flick may only cross the swipe threshold on release
+      return swipe(result);
+    }
+    if (_double_tap_window == 0)
+    {
+      fill(result, SINGLE_CLICK);
+      return true;
+    }
+    _tap_pending = true;
+    _tap_time = event.timestamp;
+    _tap_x = _x;
+    _tap_y = _y;
+    return false;
+  }
+
+  if (!_moved && (abs(_x - _x0) > _tap_slop || abs(_y - _y0) > _tap_slop))
+  {
+    _moved = true;
+  }
+  if (_moved)
+  {
+    if (!_reported && swipe(result))
+    {
+      return true;
+    }
+    fill(result, NONE);
+    return true;
+  }
+  return poll(event.timestamp, result);
+}
+
+/*!
+    @brief  report time-based gestures
+
+    Call this periodically: a stationary finger generates no samples, so a
+    long press or an expired double-tap window is only seen here.
+  @param	now
+      current time in microseconds (micros())
+  @param	result
+      receives LONG_PRESS or SINGLE_CLICK
+  @return true if result was filled
+*/
+bool CST816S_Gesture::poll(uint32_t now, gesture_event &result)
+{
+  if (_tap_pending && !_touching && now - _tap_time > _double_tap_window)
+  {
+    _tap_pending = false;
+    fill_tap(result);
+    return true;
+  }
+
+  if (_touching && !_moved && !_reported && now - _down_time >= _long_press_time)
+  {
+    _reported = true;
+    fill(result, LONG_PRESS);
+    return true;
+  }
+  return false;
+}
+
+/*!
+    @brief  forget any touch in progress and any pending tap
+*/
+void CST816S_Gesture::reset()
+{
+  _touching = false;
+  _tap_pending = false;
+}
+
+/*!
+    @brief  start tracking a new touch
+*/
+void CST816S_Gesture::touch_down(const touch_event &event)
+{
+  _touching = true;
+  _moved = false;
+  _reported = false;
+  _down_time = event.timestamp;
+  _last_time = event.timestamp;
+  _x0 = _x = event.x;
+  _y0 = _y = event.y;
+  _vx = 0;
+  _vy = 0;
+}
+
+/*!
+    @brief  update position and smoothed velocity from a sample
+*/
+void CST816S_Gesture::track(const touch_event &event)
+{
+  uint32_t dt = event.timestamp - _last_time;
+  if (dt > 0)
+  {
+    int32_t vx = (int64_t)(event.x - _x) * 1000000 / dt;
+    int32_t vy = (int64_t)(event.y - _y) * 1000000 / dt;
+    // Exponential smoothing with alpha = 1/2
+    _vx = (_vx + vx) / 2;
+    _vy = (_vy + vy) / 2;
+  }
+  _last_time = event.timestamp;
+  _x = event.x;
+  _y = event.y;
+}
+
+/*!
+    @brief  report a swipe if distance and speed thresholds are crossed
+*/
+bool CST816S_Gesture::swipe(gesture_event &result)
+{
+  int dx = _x - _x0;
+  int dy = _y - _y0;
+  GESTURE gesture;
+
+  if (abs(dx) >= abs(dy))
+  {
+    if (abs(dx) < _swipe_distance || abs(_vx) < _swipe_velocity)
+      return false;
+    gesture = dx < 0 ? SWIPE_LEFT : SWIPE_RIGHT;
+  }
+  else
+  {
+    if (abs(dy) < _swipe_distance || abs(_vy) < _swipe_velocity)
+      return false;
+    gesture = dy < 0 ? SWIPE_UP : SWIPE_DOWN;
+  }
+
+  _reported = true;
+  fill(result, gesture);
+  return true;
+}
+
+/*!
+    @brief  fill a result from the current touch state
+*/
+void CST816S_Gesture::fill(gesture_event &result, GESTURE gesture) const
+{
+  result.gesture = gesture;
+  result.drag = _moved;
+  result.x = _x;
+  result.y = _y;
+  result.dx = _x - _x0;
+  result.dy = _y - _y0;
+  result.vx = _vx;
+  result.vy = _vy;
+}
+
+/*!
+    @brief  fill a result for the pending single tap
+*/
+void CST816S_Gesture::fill_tap(gesture_event &result) const
+{
+  result.gesture = SINGLE_CLICK;
+  result.drag = false;
+  result.x = _tap_x;
+  result.y = _tap_y;
+  result.dx = 0;
+  result.dy = 0;
+  result.vx = 0;
+  result.vy = 0;
+}
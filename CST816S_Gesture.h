@@ -0,0 +1,94 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_GESTURE_H
+#define CST816S_GESTURE_H
+
+#include "CST816S.h"
+
+struct gesture_event {
+  GESTURE gesture; // Recognized gesture, NONE for plain drag updates
+  bool drag;       // Finger moved beyond the tap slop
+  int x;           // Current position
+  int y;
+  int dx;          // Movement since touch down
+  int dy;
+  int vx;          // Smoothed velocity in px/s
+  int vy;
+};
+
+/*!
+    @brief  Incremental software gesture recognizer
+
+    Works on the raw coordinate stream, e.g. with hardware gestures disabled
+    through set_motion_mask(). O(1) per sample, no heap, integer math.
+    Gestures are reported as soon as they are unambiguous: swipes mid-drag,
+    long presses while the finger is still down, double taps on the second
+    touch down. A single tap is only ambiguous while double taps are
+    enabled, and is reported once the double-tap window expires.
+*/
+class CST816S_Gesture {
+  public:
+    void set_tap_slop(int pixels);
+    void set_swipe_distance(int pixels);
+    void set_swipe_velocity(int pixels_per_second);
+    void set_long_press_time(uint32_t ms);
+    void set_double_tap_window(uint32_t ms);
+
+    bool update(const touch_event &event, gesture_event &result);
+    bool poll(uint32_t now, gesture_event &result);
+    void reset();
+
+  private:
+    int _tap_slop = 10;
+    int _swipe_distance = 40;
+    int _swipe_velocity = 200;
+    uint32_t _long_press_time = 800000;   // us
+    uint32_t _double_tap_window = 300000; // us, 0 disables double taps
+
+    bool _touching = false;
+    bool _moved = false;
+    bool _reported = false;  // a gesture was already reported for this touch
+    uint32_t _down_time = 0;
+    uint32_t _last_time = 0;
+    int _x0 = 0;
+    int _y0 = 0;
+    int _x = 0;
+    int _y = 0;
+    int32_t _vx = 0;
+    int32_t _vy = 0;
+
+    bool _tap_pending = false;
+    uint32_t _tap_time = 0;
+    int _tap_x = 0;
+    int _tap_y = 0;
+
+    void touch_down(const touch_event &event);
+    void track(const touch_event &event);
+    bool swipe(gesture_event &result);
+    void fill(gesture_event &result, GESTURE gesture) const;
+    void fill_tap(gesture_event &result) const;
+};
+
+#endif
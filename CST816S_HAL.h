@@ -0,0 +1,313 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_HAL_H
+#define CST816S_HAL_H
+
+// Platform layer between the driver core (report decoding, configuration,
+// power modes) and the board: time, delays, GPIO and interrupts. Builds with
+// the Arduino core use the Arduino API. ESP-IDF builds without it use the
+// IDF drivers directly (esp_timer, GPIO ISR service); I2C then goes through
+// CST816S_IDFTransport. Force a backend with -DCST816S_HAL_IDF=0/1.
+// -DCST816S_HAL_NATIVE=1 builds for the host (PlatformIO native env):
+// the system clock and in-memory pins, with I2C through a custom transport
+// such as CST816S_ReplayTransport.
+#ifndef CST816S_HAL_NATIVE
+#define CST816S_HAL_NATIVE 0
+#endif
+
+#ifndef CST816S_HAL_IDF
+#if defined(ESP_PLATFORM) && !defined(ARDUINO) && !CST816S_HAL_NATIVE
+#define CST816S_HAL_IDF 1
+#else
+#define CST816S_HAL_IDF 0
+#endif
+#endif
+
+// TwoWire, String and Print are only available with the Arduino core
+#define CST816S_HAL_ARDUINO (!CST816S_HAL_IDF && !CST816S_HAL_NATIVE)
+
+// Every backend provides CST816S_LOW/HIGH and the interrupt modes
+// CST816S_RISING/FALLING/CHANGE for begin(). The IDF and native backends
+// define no Arduino names here, as every application includes this header;
+// the library sources get them from CST816S_HAL_Compat.h.
+
+#if CST816S_HAL_IDF
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <esp_rom_sys.h>
+#include <driver/gpio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <hal/gpio_ll.h>
+
+#define CST816S_LOW     0
+#define CST816S_HIGH    1
+#define CST816S_RISING  GPIO_INTR_POSEDGE
+#define CST816S_FALLING GPIO_INTR_NEGEDGE
+#define CST816S_CHANGE  GPIO_INTR_ANYEDGE
+
+static inline uint32_t cst816s_millis()
+{
+  return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static inline uint32_t IRAM_ATTR cst816s_micros()
+{
+  return (uint32_t)esp_timer_get_time();
+}
+
+static inline void cst816s_delay(uint32_t ms)
+{
+  // Delays shorter than a tick would round up to a whole tick
+  if (ms < portTICK_PERIOD_MS)
+  {
+    esp_rom_delay_us(ms * 1000);
+    return;
+  }
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+static inline void cst816s_delay_us(uint32_t us)
+{
+  esp_rom_delay_us(us);
+}
+
+static inline void cst816s_pin_mode(int pin, int mode)
+{
+  gpio_num_t gpio = static_cast<gpio_num_t>(pin);
+  gpio_reset_pin(gpio);
+  gpio_set_direction(gpio, static_cast<gpio_mode_t>(mode));
+  gpio_set_pull_mode(gpio, mode == GPIO_MODE_INPUT ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
+}
+
+static inline void IRAM_ATTR cst816s_digital_write(int pin, uint8_t level)
+{
+  gpio_set_level(static_cast<gpio_num_t>(pin), level);
+}
+
+static inline int IRAM_ATTR cst816s_digital_read(int pin)
+{
+  // gpio_get_level() lives in flash; the ISR's level check runs with the
+  // cache disabled under ESP_INTR_FLAG_IRAM
+  return gpio_ll_get_level(&GPIO, static_cast<gpio_num_t>(pin));
+}
+
+static inline void cst816s_attach_irq(int pin, void (*isr)(void *), void *arg, int mode)
+{
+  gpio_num_t gpio = static_cast<gpio_num_t>(pin);
+  gpio_install_isr_service(ESP_INTR_FLAG_IRAM);  // ESP_ERR_INVALID_STATE if already installed
+  gpio_set_intr_type(gpio, static_cast<gpio_int_type_t>(mode));
+  gpio_isr_handler_add(gpio, isr, arg);
+  gpio_intr_enable(gpio);
+}
+
+static inline void cst816s_detach_irq(int pin)
+{
+  gpio_num_t gpio = static_cast<gpio_num_t>(pin);
+  gpio_intr_disable(gpio);
+  gpio_isr_handler_remove(gpio);
+}
+
+#elif CST816S_HAL_NATIVE
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#define CST816S_LOW     0
+#define CST816S_HIGH    1
+#define CST816S_RISING  0x01
+#define CST816S_FALLING 0x02
+#define CST816S_CHANGE  0x03
+
+#define CST816S_NATIVE_INPUT        0x01
+#define CST816S_NATIVE_INPUT_PULLUP 0x05
+#define CST816S_NATIVE_OUTPUT       0x03
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+#define CST816S_NATIVE_PINS 64
+
+// Simulated board: pin levels and attached interrupt handlers
+struct cst816s_native_board {
+  uint8_t level[CST816S_NATIVE_PINS];
+  void (*isr[CST816S_NATIVE_PINS])(void *);
+  void *arg[CST816S_NATIVE_PINS];
+};
+
+inline cst816s_native_board cst816s_native = {};
+
+static inline uint64_t cst816s_native_us()
+{
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static inline uint32_t cst816s_millis()
+{
+  return (uint32_t)(cst816s_native_us() / 1000);
+}
+
+static inline uint32_t cst816s_micros()
+{
+  return (uint32_t)cst816s_native_us();
+}
+
+static inline void cst816s_delay(uint32_t ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static inline void cst816s_delay_us(uint32_t us)
+{
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static inline bool cst816s_native_pin(int pin)
+{
+  return pin >= 0 && pin < CST816S_NATIVE_PINS;
+}
+
+static inline void cst816s_pin_mode(int pin, int mode)
+{
+  if (cst816s_native_pin(pin) && mode == CST816S_NATIVE_INPUT_PULLUP)
+    cst816s_native.level[pin] = CST816S_HIGH;
+}
+
+static inline void cst816s_digital_write(int pin, uint8_t level)
+{
+  if (cst816s_native_pin(pin))
+    cst816s_native.level[pin] = level;
+}
+
+static inline int cst816s_digital_read(int pin)
+{
+  return cst816s_native_pin(pin) ? cst816s_native.level[pin] : CST816S_LOW;
+}
+
+static inline void cst816s_attach_irq(int pin, void (*isr)(void *), void *arg, int mode)
+{
+  (void)mode;
+  if (cst816s_native_pin(pin))
+  {
+    cst816s_native.isr[pin] = isr;
+    cst816s_native.arg[pin] = arg;
+  }
+}
+
+static inline void cst816s_detach_irq(int pin)
+{
+  if (cst816s_native_pin(pin))
+    cst816s_native.isr[pin] = nullptr;
+}
+
+/*!
+    @brief  run the handler attached to a pin, as a hardware edge would
+*/
+static inline void cst816s_native_interrupt(int pin)
+{
+  if (cst816s_native_pin(pin) && cst816s_native.isr[pin] != nullptr)
+    cst816s_native.isr[pin](cst816s_native.arg[pin]);
+}
+
+#else
+
+#include <Arduino.h>
+
+#define CST816S_LOW     LOW
+#define CST816S_HIGH    HIGH
+#define CST816S_RISING  RISING
+#define CST816S_FALLING FALLING
+#define CST816S_CHANGE  CHANGE
+
+static inline uint32_t cst816s_millis()
+{
+  return millis();
+}
+
+static inline uint32_t IRAM_ATTR cst816s_micros()
+{
+  return micros();
+}
+
+static inline void cst816s_delay(uint32_t ms)
+{
+  delay(ms);
+}
+
+static inline void cst816s_delay_us(uint32_t us)
+{
+  delayMicroseconds(us);
+}
+
+static inline void cst816s_pin_mode(int pin, int mode)
+{
+  pinMode(pin, mode);
+}
+
+static inline void IRAM_ATTR cst816s_digital_write(int pin, uint8_t level)
+{
+  digitalWrite(pin, level);
+}
+
+static inline int IRAM_ATTR cst816s_digital_read(int pin)
+{
+  return digitalRead(pin);
+}
+
+static inline void cst816s_attach_irq(int pin, void (*isr)(void *), void *arg, int mode)
+{
+  attachInterruptArg(pin, isr, arg, mode);
+}
+
+static inline void cst816s_detach_irq(int pin)
+{
+  detachInterrupt(pin);
+}
+
+#endif
+
+// ESP32 family features (acquisition task, MCU sleep, fast GPIO) only need
+// IDF, so IDF builds get them without the Arduino board macro
+#ifndef CST816S_ESP32
+#if defined(ESP32) || (CST816S_HAL_IDF && !defined(CONFIG_IDF_TARGET_ESP8266))
+#define CST816S_ESP32 1
+#else
+#define CST816S_ESP32 0
+#endif
+#endif
+
+#endif
@@ -0,0 +1,59 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_HAL_COMPAT_H
+#define CST816S_HAL_COMPAT_H
+
+// Arduino names the driver sources are written against, for the IDF and
+// native backends. Only the library's .cpp files include this, after all
+// other headers, so the names never reach application code.
+
+#include "CST816S_HAL.h"
+
+#if CST816S_HAL_IDF || CST816S_HAL_NATIVE
+
+typedef uint8_t byte;
+
+#define LOW     CST816S_LOW
+#define HIGH    CST816S_HIGH
+#define RISING  CST816S_RISING
+#define FALLING CST816S_FALLING
+#define CHANGE  CST816S_CHANGE
+
+#if CST816S_HAL_IDF
+#define OUTPUT       GPIO_MODE_OUTPUT
+#define INPUT_PULLUP GPIO_MODE_INPUT
+#else
+#define INPUT        CST816S_NATIVE_INPUT
+#define INPUT_PULLUP CST816S_NATIVE_INPUT_PULLUP
+#define OUTPUT       CST816S_NATIVE_OUTPUT
+#endif
+
+#define PROGMEM
+#define pgm_read_ptr(addr) (*(const void *const *)(addr))
+#define strncpy_P strncpy
+
+#endif
+
+#endif
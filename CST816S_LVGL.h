@@ -0,0 +1,106 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_LVGL_H
+#define CST816S_LVGL_H
+
+#include <lvgl.h>
+#include "CST816S.h"
+
+/*!
+    @brief  LVGL input device fed from the CST816S event queue
+
+    The read callback only takes samples that are already queued, so the
+    LVGL timer handler never waits on I2C. Fill the queue from the
+    acquisition task (begin_task()), a CST816S_Bus or by calling service()
+    before lv_timer_handler(). While more samples are queued the callback
+    asks LVGL to read again, so a buffered drag is delivered in full rather
+    than one sample per LVGL tick. Works with LVGL 8 and 9.
+*/
+class CST816S_LVGL {
+  public:
+    explicit CST816S_LVGL(CST816S &touch) : _touch(&touch) {}
+
+    /*!
+        @brief  register the pointer input device with LVGL
+      @return the created input device
+    */
+    lv_indev_t *begin()
+    {
+#if LVGL_VERSION_MAJOR >= 9
+      _indev = lv_indev_create();
+      lv_indev_set_type(_indev, LV_INDEV_TYPE_POINTER);
+      lv_indev_set_read_cb(_indev, read_cb);
+      lv_indev_set_user_data(_indev, this);
+#else
+      lv_indev_drv_init(&_drv);
+      _drv.type = LV_INDEV_TYPE_POINTER;
+      _drv.read_cb = read_cb;
+      _drv.user_data = this;
+      _indev = lv_indev_drv_register(&_drv);
+#endif
+      return _indev;
+    }
+
+    lv_indev_t *indev() const { return _indev; }
+
+  private:
+    CST816S *_touch;
+    lv_indev_t *_indev = nullptr;
+#if LVGL_VERSION_MAJOR < 9
+    lv_indev_drv_t _drv;
+#endif
+    int32_t _x = 0;
+    int32_t _y = 0;
+    bool _pressed = false;
+
+    void read(lv_indev_data_t *data)
+    {
+      touch_event event;
+      if (_touch->pop_queued(event))
+      {
+        _x = event.x;
+        _y = event.y;
+        _pressed = event.event != 1;  // down and contact press, up releases
+        data->continue_reading = _touch->events_pending() > 0;
+      }
+      data->point.x = _x;
+      data->point.y = _y;
+      data->state = _pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    }
+
+#if LVGL_VERSION_MAJOR >= 9
+    static void read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+    {
+      static_cast<CST816S_LVGL *>(lv_indev_get_user_data(indev))->read(data);
+    }
+#else
+    static void read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+    {
+      static_cast<CST816S_LVGL *>(drv->user_data)->read(data);
+    }
+#endif
+};
+
+#endif
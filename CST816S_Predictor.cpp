@@ -0,0 +1,122 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CST816S_Predictor.h"
+
+// Gaps longer than this restart tracking instead of integrating velocity
+#define PREDICTOR_MAX_GAP_US 100000
+
+/*!
+    @brief  Constructor for CST816S_Predictor
+  @param	lead_us
+      how far ahead to extrapolate, typically one or two report periods
+*/
+CST816S_Predictor::CST816S_Predictor(uint32_t lead_us)
+{
+  _lead = lead_us;
+}
+
+/*!
+    @brief  set how far ahead to extrapolate
+  @param	us
+      lead time in microseconds, 0 only smooths
+*/
+void CST816S_Predictor::set_lead_time(uint32_t us)
+{
+  _lead = us;
+}
+
+/*!
+    @brief  set the filter gains
+  @param	alpha
+      position gain in 1/256 units, higher follows the measurement more closely
+  @param	beta
+      velocity gain in 1/256 units, higher reacts faster to speed changes
+*/
+void CST816S_Predictor::set_gains(uint8_t alpha, uint8_t beta)
+{
+  _alpha = alpha;
+  _beta = beta;
+}
+
+/*!
+    @brief  filter one sample and replace x/y with the predicted position
+
+    Touch down restarts tracking, touch up reports the measured position.
+  @param	event
+      sample to update in place
+*/
+void CST816S_Predictor::apply(touch_event &event)
+{
+  uint32_t dt = event.timestamp - _last_time;
+
+  // Event: 0 = Down, 1 = Up, 2 = Contact
+  if (event.event != 2 || !_tracking || dt == 0 || dt > PREDICTOR_MAX_GAP_US)
+  {
+    _tracking = event.event != 1;
+    _last_time = event.timestamp;
+    _x = event.x << 8;
+    _y = event.y << 8;
+    _vx = 0;
+    _vy = 0;
+    return;
+  }
+  _last_time = event.timestamp;
+
+  step(_x, _vx, event.x, dt);
+  step(_y, _vy, event.y, dt);
+
+  event.x = extrapolate(_x, _vx);
+  event.y = extrapolate(_y, _vy);
+}
+
+/*!
+    @brief  stop tracking, the next sample starts afresh
+*/
+void CST816S_Predictor::reset()
+{
+  _tracking = false;
+}
+
+/*!
+    @brief  one alpha-beta update on a single axis
+*/
+void CST816S_Predictor::step(int32_t &position, int32_t &velocity, int measured, uint32_t dt)
+{
+  int32_t predicted = position + (int32_t)((int64_t)velocity * dt / 1000000);
+  int32_t residual = (measured << 8) - predicted;
+
+  position = predicted + ((_alpha * residual) >> 8);
+  velocity += (int32_t)((int64_t)_beta * residual * 1000000 / ((int64_t)dt << 8));
+}
+
+/*!
+    @brief  position after the lead time, in px
+*/
+int CST816S_Predictor::extrapolate(int32_t position, int32_t velocity) const
+{
+  int32_t ahead = position + (int32_t)((int64_t)velocity * _lead / 1000000);
+  ahead = (ahead + 128) >> 8;
+  return ahead < 0 ? 0 : ahead;
+}
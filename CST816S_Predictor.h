@@ -0,0 +1,62 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_PREDICTOR_H
+#define CST816S_PREDICTOR_H
+
+#include "CST816S.h"
+
+/*!
+    @brief  Fixed-point alpha-beta motion predictor
+
+    Tracks position and velocity from the per-sample timestamps and replaces
+    the event's x/y with the position extrapolated by the lead time, so a
+    dragged object keeps up with the finger. point[0] keeps the measured
+    coordinates. Attach it with CST816S::set_predictor().
+*/
+class CST816S_Predictor {
+  public:
+    explicit CST816S_Predictor(uint32_t lead_us = 16000);
+    void set_lead_time(uint32_t us);
+    void set_gains(uint8_t alpha, uint8_t beta);
+    void apply(touch_event &event);
+    void reset();
+
+  private:
+    uint32_t _lead;
+    int32_t _alpha = 192;  // position gain, Q8 (0.75)
+    int32_t _beta = 115;   // velocity gain, Q8 (0.45, critically damped)
+
+    bool _tracking = false;
+    uint32_t _last_time = 0;
+    int32_t _x = 0;   // position, Q8 px
+    int32_t _y = 0;
+    int32_t _vx = 0;  // velocity, Q8 px/s
+    int32_t _vy = 0;
+
+    void step(int32_t &position, int32_t &velocity, int measured, uint32_t dt);
+    int extrapolate(int32_t position, int32_t velocity) const;
+};
+
+#endif
@@ -0,0 +1,395 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CST816S_Recorder.h"
+
+/*!
+    @brief  Constructor for CST816S_Recorder
+  @param	buffer
+      ring buffer storage, one byte of it is kept free
+  @param	size
+      size of the buffer in bytes
+  @param	frame_size
+      bytes per report frame, CST816S_REPORT_SIZE for the driver's reads
+*/
+CST816S_Recorder::CST816S_Recorder(uint8_t *buffer, size_t size, size_t frame_size)
+{
+  _buffer = buffer;
+  _size = size;
+  _frame_size = frame_size;
+}
+
+/*!
+    @brief  start logging reports, the first one is recorded with a zero delta
+*/
+void CST816S_Recorder::start()
+{
+  _started = false;
+  _recording = true;
+}
+
+/*!
+    @brief  stop logging reports, buffered data stays available to flush()
+*/
+void CST816S_Recorder::stop()
+{
+  _recording = false;
+}
+
+/*!
+    @brief  keep the most recent reports when the buffer is full
+  @param	enable
+      true to overwrite the oldest reports instead of dropping new ones
+*/
+void CST816S_Recorder::set_overwrite(bool enable)
+{
+  _overwrite = enable;
+}
+
+/*!
+    @brief  discard buffered data; the next flush starts a new stream with a header
+*/
+void CST816S_Recorder::clear()
+{
+  _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+  _header_written = 0;
+  _started = false;
+  _frames = 0;
+  _dropped = 0;
+  _write_errors = 0;
+}
+
+/*!
+    @brief  append a report frame
+  @param	timestamp
+      time of the report in microseconds
+  @param	frame
+      raw report block starting at register 0x01
+  @param	length
+      bytes in frame, ignored unless it matches the frame size
+*/
+void CST816S_Recorder::record(uint32_t timestamp, const uint8_t *frame, size_t length)
+{
+  if (!_recording || length != _frame_size)
+  {
+    return;
+  }
+
+  uint8_t varint[5];
+  size_t n = 0;
+  uint32_t delta = _started ? timestamp - _last : 0;
+  do
+  {
+    uint8_t b = delta & 0x7F;
+    delta >>= 7;
+    varint[n++] = delta ? (b | 0x80) : b;
+  } while (delta);
+
+  size_t needed = n + _frame_size;
+  if (needed >= _size)
+  {
+    _dropped++;
+    return;
+  }
+  size_t head = _head.load(std::memory_order_relaxed);
+  while (_size - 1 - pending() < needed)
+  {
+    if (!_overwrite)
+    {
+      // keep _last so the next record's delta spans the gap
+      _dropped++;
+      return;
+    }
+    drop_oldest();
+  }
+
+  for (size_t i = 0; i < n; i++)
+  {
+    _buffer[head] = varint[i];
+    head = (head + 1) % _size;
+  }
+  for (size_t i = 0; i < _frame_size; i++)
+  {
+    _buffer[head] = frame[i];
+    head = (head + 1) % _size;
+  }
+  _head.store(head, std::memory_order_release);
+
+  _started = true;
+  _last = timestamp;
+  _frames++;
+}
+
+/*!
+    @brief  remove the oldest record to make room (overwrite mode)
+*/
+void CST816S_Recorder::drop_oldest()
+{
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  while (_buffer[tail] & 0x80)
+  {
+    tail = (tail + 1) % _size;
+  }
+  tail = (tail + 1 + _frame_size) % _size;
+  _tail.store(tail, std::memory_order_release);
+  _dropped++;
+}
+
+/*!
+    @brief  bytes buffered and not yet flushed, header excluded
+*/
+size_t CST816S_Recorder::pending() const
+{
+  size_t head = _head.load(std::memory_order_acquire);
+  size_t tail = _tail.load(std::memory_order_acquire);
+  return (head + _size - tail) % _size;
+}
+
+/*!
+    @brief  fill in the stream header
+*/
+size_t CST816S_Recorder::header(uint8_t *out) const
+{
+  out[0] = 'C';
+  out[1] = 'S';
+  out[2] = CST816S_RECORD_VERSION;
+  out[3] = _frame_size;
+  return CST816S_RECORD_HEADER_SIZE;
+}
+
+#if CST816S_HAL_ARDUINO
+/*!
+    @brief  write buffered records to a stream, e.g. a LittleFS File
+
+    The header is written before the first records of a stream. Call it
+    periodically from a low priority context; each call is at most three
+    writes regardless of the number of records. Only what the stream
+    accepted is removed from the buffer, so after a short write (e.g. a
+    full file system) the rest stays pending for the next call and
+    write_errors() is incremented.
+  @param	out
+      destination
+  @return number of bytes written
+*/
+size_t CST816S_Recorder::flush(Print &out)
+{
+  size_t written = 0;
+  if (_header_written < CST816S_RECORD_HEADER_SIZE)
+  {
+    uint8_t prefix[CST816S_RECORD_HEADER_SIZE];
+    header(prefix);
+    size_t length = CST816S_RECORD_HEADER_SIZE - _header_written;
+    size_t n = out.write(&prefix[_header_written], length);
+    _header_written += n;
+    written += n;
+    if (n < length)
+    {
+      _write_errors++;
+      return written;
+    }
+  }
+
+  size_t head = _head.load(std::memory_order_acquire);
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  while (tail != head)
+  {
+    // Up to the end of the buffer first, then from its start
+    size_t length = tail > head ? _size - tail : head - tail;
+    size_t n = out.write(&_buffer[tail], length);
+    written += n;
+    tail = (tail + n) % _size;
+    _tail.store(tail, std::memory_order_release);
+    if (n < length)
+    {
+      _write_errors++;
+      break;
+    }
+  }
+  return written;
+}
+#endif
+
+/*!
+    @brief  copy buffered records to memory
+  @param	out
+      destination, the stream continues across calls
+  @param	max
+      capacity of out, must hold at least the header
+  @return number of bytes copied
+*/
+size_t CST816S_Recorder::flush(uint8_t *out, size_t max)
+{
+  size_t written = 0;
+  if (_header_written < CST816S_RECORD_HEADER_SIZE)
+  {
+    if (max < CST816S_RECORD_HEADER_SIZE)
+    {
+      return 0;
+    }
+    written += header(out);
+    _header_written = CST816S_RECORD_HEADER_SIZE;
+  }
+
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  size_t count = pending();
+  if (count > max - written)
+  {
+    count = max - written;
+  }
+  for (size_t i = 0; i < count; i++)
+  {
+    out[written++] = _buffer[tail];
+    tail = (tail + 1) % _size;
+  }
+  _tail.store(tail, std::memory_order_release);
+  return written;
+}
+
+/*!
+    @brief  Constructor for CST816S_Player
+  @param	data
+      recording produced by CST816S_Recorder::flush(), header included
+  @param	length
+      size of the recording in bytes
+*/
+CST816S_Player::CST816S_Player(const uint8_t *data, size_t length)
+{
+  _data = data;
+  _length = length;
+  if (length >= CST816S_RECORD_HEADER_SIZE && data[0] == 'C' && data[1] == 'S' &&
+      data[2] == CST816S_RECORD_VERSION)
+  {
+    _frame_size = data[3];
+  }
+}
+
+/*!
+    @brief  choose between recorded timing and replaying as fast as possible
+  @param	enable
+      true (default) to wait for each report's recorded delay, false to
+      feed a new report on every update()
+*/
+void CST816S_Player::set_realtime(bool enable)
+{
+  _realtime = enable;
+}
+
+/*!
+    @brief  feed the next recorded report when it is due
+  @param	touch
+      driver using this player as its transport
+  @return true if a report was raised
+*/
+bool CST816S_Player::update(CST816S &touch)
+{
+  if (!valid())
+  {
+    return false;
+  }
+
+  uint32_t delta = 0;
+  size_t pos = _pos;
+  for (uint8_t shift = 0; pos < _length && shift < 35; shift += 7)
+  {
+    uint8_t b = _data[pos++];
+    delta |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80))
+    {
+      break;
+    }
+  }
+  if (pos + _frame_size > _length)
+  {
+    return false;
+  }
+
+  uint32_t now = cst816s_micros();
+  uint32_t due = _due + delta;
+  if (!_started)
+  {
+    // the first delta is relative to a report that was not recorded
+    _started = true;
+    _clock = now;
+    due = 0;
+  }
+  if (_realtime && now - _clock < due)
+  {
+    return false;
+  }
+
+  _frame = &_data[pos];
+  _pos = pos + _frame_size;
+  _due = due;
+  _played++;
+  touch.inject_interrupt();
+  return true;
+}
+
+/*!
+    @brief  true once every recorded report has been fed
+*/
+bool CST816S_Player::finished() const
+{
+  return !valid() || _pos >= _length || _length - _pos < 1 + _frame_size;
+}
+
+/*!
+    @brief  restart from the first recorded report
+*/
+void CST816S_Player::rewind()
+{
+  _pos = CST816S_RECORD_HEADER_SIZE;
+  _frame = nullptr;
+  _started = false;
+  _due = 0;
+  _played = 0;
+}
+
+/*!
+    @brief  serve report block reads (register 0x01) from the current frame
+
+    Other registers read as zero, so the FingerNum precheck used when
+    polling never triggers reads of its own.
+*/
+uint8_t CST816S_Player::read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length)
+{
+  (void)addr;
+  for (size_t i = 0; i < length; i++)
+  {
+    data[i] = (reg == 0x01 && _frame != nullptr && i < _frame_size) ? _frame[i] : 0;
+  }
+  return 0;
+}
+
+/*!
+    @brief  accept and ignore register writes
+*/
+uint8_t CST816S_Player::write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length)
+{
+  (void)addr;
+  (void)reg;
+  (void)data;
+  (void)length;
+  return 0;
+}
@@ -0,0 +1,121 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_RECORDER_H
+#define CST816S_RECORDER_H
+
+#include <atomic>
+#include "CST816S.h"
+
+// Recording stream: a 4 byte header ('C', 'S', version, frame size), then
+// one record per report: the microseconds since the previous report as an
+// LEB128 varint, followed by the raw report frame read from register 0x01.
+#define CST816S_RECORD_VERSION     1
+#define CST816S_RECORD_HEADER_SIZE 4
+
+/*!
+    @brief  Logs raw report frames into a ring buffer
+
+    The buffer is supplied by the caller, so it can live in internal RAM or
+    PSRAM (e.g. from ps_malloc()). record() is called from the read path;
+    flush() drains the buffer from another context into any Print, such as
+    a LittleFS File, in at most three writes per call. Without overwrite,
+    recording and flushing may run concurrently and new reports are dropped
+    when the buffer is full. With overwrite the oldest reports are replaced
+    instead, and flush() must only be called after stop().
+*/
+class CST816S_Recorder {
+  public:
+    CST816S_Recorder(uint8_t *buffer, size_t size, size_t frame_size = CST816S_REPORT_SIZE);
+    void start();
+    void stop();
+    bool recording() const { return _recording; }
+    void set_overwrite(bool enable);
+    void clear();
+
+    void record(uint32_t timestamp, const uint8_t *frame, size_t length);
+#if CST816S_HAL_ARDUINO
+    size_t flush(Print &out);
+#endif
+    size_t flush(uint8_t *out, size_t max);
+
+    size_t pending() const;
+    uint32_t frames() const { return _frames; }
+    uint32_t dropped() const { return _dropped; }
+    uint32_t write_errors() const { return _write_errors; }
+
+  private:
+    uint8_t *_buffer;
+    size_t _size;
+    size_t _frame_size;
+    std::atomic<size_t> _head{0};
+    std::atomic<size_t> _tail{0};
+    volatile bool _recording = false;
+    bool _overwrite = false;
+    bool _started = false;
+    uint8_t _header_written = 0;  // header bytes already flushed
+    uint32_t _last = 0;
+    uint32_t _frames = 0;
+    uint32_t _dropped = 0;
+    uint32_t _write_errors = 0;
+
+    void drop_oldest();
+    size_t header(uint8_t *out) const;
+};
+
+/*!
+    @brief  Replays a recording through the normal driver event path
+
+    Acts as the controller's transport: reads of the report registers return
+    the current recorded frame. update() advances to the next frame when its
+    time has come and raises inject_interrupt(), so the frame goes through
+    decode, transform, filtering, the queue and dispatch like a live report.
+*/
+class CST816S_Player : public CST816S_Transport {
+  public:
+    CST816S_Player(const uint8_t *data, size_t length);
+    bool valid() const { return _frame_size != 0; }
+    void set_realtime(bool enable);
+    bool update(CST816S &touch);
+    bool finished() const;
+    void rewind();
+    uint32_t frames_played() const { return _played; }
+
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override;
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override;
+
+  private:
+    const uint8_t *_data;
+    size_t _length;
+    size_t _frame_size = 0;
+    size_t _pos = CST816S_RECORD_HEADER_SIZE;
+    const uint8_t *_frame = nullptr;
+    bool _realtime = true;
+    bool _started = false;
+    uint32_t _clock = 0;
+    uint32_t _due = 0;
+    uint32_t _played = 0;
+};
+
+#endif
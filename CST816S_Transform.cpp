@@ -0,0 +1,285 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CST816S_Transform.h"
+
+/*!
+    @brief  Constructor for CST816S_Transform, starts as identity
+*/
+CST816S_Transform::CST816S_Transform()
+{
+  reset();
+}
+
+/*!
+    @brief  rotate coordinates to match the display orientation
+
+    Also sets the native panel size that rotation and mirroring need.
+    Like set_mirror() and set_screen(), this replaces a mapping loaded with
+    calibrate() or set_matrix().
+  @param	rotation
+      clockwise rotation in 90 degree steps (0-3)
+  @param	width
+      native panel width in touch coordinates
+  @param	height
+      native panel height in touch coordinates
+*/
+void CST816S_Transform::set_rotation(uint8_t rotation, int width, int height)
+{
+  _rotation = rotation & 3;
+  _width = width;
+  _height = height;
+  update();
+}
+
+/*!
+    @brief  mirror coordinates after rotation
+
+    Mirroring needs the native panel size, so it only takes effect once
+    set_rotation() has given one.
+  @param	mirror_x
+      flip horizontally
+  @param	mirror_y
+      flip vertically
+*/
+void CST816S_Transform::set_mirror(bool mirror_x, bool mirror_y)
+{
+  _mirror_x = mirror_x;
+  _mirror_y = mirror_y;
+  update();
+}
+
+/*!
+    @brief  scale rotated coordinates to the screen resolution
+
+    Needs the native panel size from set_rotation().
+  @param	width
+      screen width in pixels, 0 disables scaling
+  @param	height
+      screen height in pixels
+*/
+void CST816S_Transform::set_screen(int width, int height)
+{
+  _screen_width = width;
+  _screen_height = height;
+  update();
+}
+
+/*!
+    @brief  use an explicit affine matrix
+  @param	matrix
+      Q16 coefficients {a, b, c, d, e, f}: x' = a x + b y + c, y' = d x + e y + f
+*/
+void CST816S_Transform::set_matrix(const int32_t matrix[6])
+{
+  memcpy(_m, matrix, sizeof(_m));
+  _mode = TRANSFORM_AFFINE;
+}
+
+/*!
+    @brief  fit the affine matrix to measured touch/screen point pairs
+
+    Least-squares fit over at least three non-collinear points, e.g. the
+    user tapping crosshairs on screen. Collect the touch points with the
+    transform reset, since the fit maps raw coordinates and already
+    includes any rotation, mirroring and scaling. A later set_rotation(),
+    set_mirror() or set_screen() replaces the fitted matrix, so call this
+    last.
+  @return false if there are too few points or they are collinear
+*/
+bool CST816S_Transform::calibrate(const int *touch_x, const int *touch_y,
+                                  const int *screen_x, const int *screen_y, size_t count)
+{
+  if (count < 3)
+  {
+    return false;
+  }
+
+  // Normal equations: [sxx sxy sx; sxy syy sy; sx sy n] * coeffs = rhs
+  double sxx = 0, sxy = 0, syy = 0, sx = 0, sy = 0, n = count;
+  double rx[3] = {0, 0, 0};
+  double ry[3] = {0, 0, 0};
+  for (size_t i = 0; i < count; i++)
+  {
+    double x = touch_x[i];
+    double y = touch_y[i];
+    sxx += x * x;
+    sxy += x * y;
+    syy += y * y;
+    sx += x;
+    sy += y;
+    rx[0] += x * screen_x[i];
+    rx[1] += y * screen_x[i];
+    rx[2] += screen_x[i];
+    ry[0] += x * screen_y[i];
+    ry[1] += y * screen_y[i];
+    ry[2] += screen_y[i];
+  }
+
+  double det = sxx * (syy * n - sy * sy) - sxy * (sxy * n - sy * sx) + sx * (sxy * sy - syy * sx);
+  if (det > -1e-9 && det < 1e-9)
+  {
+    return false;
+  }
+
+  // Cramer's rule for both output axes
+  const double *rhs[2] = {rx, ry};
+  for (int axis = 0; axis < 2; axis++)
+  {
+    const double *r = rhs[axis];
+    double a = (r[0] * (syy * n - sy * sy) - sxy * (r[1] * n - sy * r[2]) + sx * (r[1] * sy - syy * r[2])) / det;
+    double b = (sxx * (r[1] * n - sy * r[2]) - r[0] * (sxy * n - sy * sx) + sx * (sxy * r[2] - r[1] * sx)) / det;
+    double c = (sxx * (syy * r[2] - r[1] * sy) - sxy * (sxy * r[2] - r[1] * sx) + r[0] * (sxy * sy - syy * sx)) / det;
+    _m[axis * 3 + 0] = (int32_t)(a * 65536.0 + (a < 0 ? -0.5 : 0.5));
+    _m[axis * 3 + 1] = (int32_t)(b * 65536.0 + (b < 0 ? -0.5 : 0.5));
+    _m[axis * 3 + 2] = (int32_t)(c * 65536.0 + (c < 0 ? -0.5 : 0.5));
+  }
+  _mode = TRANSFORM_AFFINE;
+  return true;
+}
+
+/*!
+    @brief  back to identity: no rotation, mirroring, scaling or calibration
+*/
+void CST816S_Transform::reset()
+{
+  _rotation = 0;
+  _mirror_x = false;
+  _mirror_y = false;
+  _width = 0;
+  _height = 0;
+  _screen_width = 0;
+  _screen_height = 0;
+  update();
+}
+
+/*!
+    @brief  transform one coordinate pair in place
+*/
+void CST816S_Transform::map(int &x, int &y) const
+{
+  switch (_mode)
+  {
+  case TRANSFORM_IDENTITY:
+    return;
+  case TRANSFORM_FAST:
+  {
+    int rx, ry;
+    switch (_rotation)
+    {
+    case 1:
+      rx = _height - 1 - y;
+      ry = x;
+      break;
+    case 2:
+      rx = _width - 1 - x;
+      ry = _height - 1 - y;
+      break;
+    case 3:
+      rx = y;
+      ry = _width - 1 - x;
+      break;
+    default:
+      rx = x;
+      ry = y;
+      break;
+    }
+    int out_width = (_rotation & 1) ? _height : _width;
+    int out_height = (_rotation & 1) ? _width : _height;
+    x = _mirror_x ? out_width - 1 - rx : rx;
+    y = _mirror_y ? out_height - 1 - ry : ry;
+    return;
+  }
+  case TRANSFORM_AFFINE:
+  {
+    int32_t tx = (int32_t)(((int64_t)_m[0] * x + (int64_t)_m[1] * y + _m[2] + 0x8000) >> 16);
+    int32_t ty = (int32_t)(((int64_t)_m[3] * x + (int64_t)_m[4] * y + _m[5] + 0x8000) >> 16);
+    x = tx;
+    y = ty;
+    return;
+  }
+  }
+}
+
+/*!
+    @brief  rebuild the mapping from rotation, mirroring and screen size
+*/
+void CST816S_Transform::update()
+{
+  // Without the panel extent there is nothing to rotate or mirror about;
+  // mirroring x to -1 - x would only produce negative coordinates
+  if ((_rotation == 0 && !_mirror_x && !_mirror_y && _screen_width == 0) ||
+      _width <= 0 || _height <= 0)
+  {
+    _mode = TRANSFORM_IDENTITY;
+    return;
+  }
+  if (_screen_width == 0)
+  {
+    _mode = TRANSFORM_FAST;
+    return;
+  }
+
+  // Express rotation and mirroring as an integer matrix, then scale each row
+  // from the rotated panel size to the screen size
+  int32_t m[6];
+  switch (_rotation)
+  {
+  case 1:
+    m[0] = 0; m[1] = -1; m[2] = _height - 1;
+    m[3] = 1; m[4] = 0;  m[5] = 0;
+    break;
+  case 2:
+    m[0] = -1; m[1] = 0;  m[2] = _width - 1;
+    m[3] = 0;  m[4] = -1; m[5] = _height - 1;
+    break;
+  case 3:
+    m[0] = 0;  m[1] = 1; m[2] = 0;
+    m[3] = -1; m[4] = 0; m[5] = _width - 1;
+    break;
+  default:
+    m[0] = 1; m[1] = 0; m[2] = 0;
+    m[3] = 0; m[4] = 1; m[5] = 0;
+    break;
+  }
+  int out_width = (_rotation & 1) ? _height : _width;
+  int out_height = (_rotation & 1) ? _width : _height;
+  if (_mirror_x)
+  {
+    m[0] = -m[0]; m[1] = -m[1]; m[2] = out_width - 1 - m[2];
+  }
+  if (_mirror_y)
+  {
+    m[3] = -m[3]; m[4] = -m[4]; m[5] = out_height - 1 - m[5];
+  }
+
+  int64_t scale_x = ((int64_t)_screen_width << 16) / out_width;
+  int64_t scale_y = ((int64_t)_screen_height << 16) / out_height;
+  for (int i = 0; i < 3; i++)
+  {
+    _m[i] = (int32_t)(m[i] * scale_x);
+    _m[3 + i] = (int32_t)(m[3 + i] * scale_y);
+  }
+  _mode = TRANSFORM_AFFINE;
+}
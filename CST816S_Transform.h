@@ -0,0 +1,68 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_TRANSFORM_H
+#define CST816S_TRANSFORM_H
+
+#include "CST816S.h"
+
+/*!
+    @brief  Maps raw touch coordinates to screen coordinates
+
+    Rotation and mirroring alone use an integer-only swap/subtract path;
+    screen scaling and calibration use a precomputed Q16 fixed-point affine
+    matrix. Floating point is only used once, when fitting a calibration.
+    Attach it with CST816S::set_transform() to have every report arrive
+    in screen coordinates.
+*/
+class CST816S_Transform {
+  public:
+    CST816S_Transform();
+    void set_rotation(uint8_t rotation, int width, int height);
+    void set_mirror(bool mirror_x, bool mirror_y);
+    void set_screen(int width, int height);
+    void set_matrix(const int32_t matrix[6]);
+    bool calibrate(const int *touch_x, const int *touch_y,
+                   const int *screen_x, const int *screen_y, size_t count);
+    void reset();
+
+    void map(int &x, int &y) const;
+
+  private:
+    enum transform_mode : uint8_t { TRANSFORM_IDENTITY, TRANSFORM_FAST, TRANSFORM_AFFINE };
+
+    transform_mode _mode;
+    uint8_t _rotation;
+    bool _mirror_x;
+    bool _mirror_y;
+    int _width;          // native panel size
+    int _height;
+    int _screen_width;   // 0 = no scaling
+    int _screen_height;
+    int32_t _m[6];       // x' = (m0 x + m1 y + m2) >> 16, y' = (m3 x + m4 y + m5) >> 16
+
+    void update();
+};
+
+#endif
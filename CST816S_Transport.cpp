@@ -0,0 +1,297 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CST816S_Transport.h"
+
+#if CST816S_HAL_IDF
+/*!
+    @brief  Constructor for CST816S_IDFTransport
+  @param	bus
+      i2c master bus created with i2c_new_master_bus()
+  @param	clock
+      SCL frequency in Hz for the devices added on this bus
+  @param	timeout_ms
+      transaction timeout
+*/
+CST816S_IDFTransport::CST816S_IDFTransport(i2c_master_bus_handle_t bus, uint32_t clock, int timeout_ms)
+{
+  _bus = bus;
+  _clock = clock;
+  _timeout_ms = timeout_ms;
+}
+
+/*!
+    @brief  device handle for an address, added to the bus on first use
+*/
+i2c_master_dev_handle_t CST816S_IDFTransport::device(uint8_t addr)
+{
+  for (int i = 0; i < CST816S_IDF_DEVICES; i++)
+  {
+    if (_devices[i] != nullptr && _addresses[i] == addr)
+    {
+      return _devices[i];
+    }
+  }
+  for (int i = 0; i < CST816S_IDF_DEVICES; i++)
+  {
+    if (_devices[i] == nullptr)
+    {
+      i2c_device_config_t config = {};
+      config.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+      config.device_address = addr;
+      config.scl_speed_hz = _clock;
+      if (i2c_master_bus_add_device(_bus, &config, &_devices[i]) != ESP_OK)
+      {
+        _devices[i] = nullptr;
+        return nullptr;
+      }
+      _addresses[i] = addr;
+      return _devices[i];
+    }
+  }
+  return nullptr;
+}
+
+/*!
+    @brief  read registers with a single write-then-read transaction
+*/
+uint8_t CST816S_IDFTransport::read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length)
+{
+  i2c_master_dev_handle_t dev = device(addr);
+  if (dev == nullptr)
+    return CST816S_ERR_NACK;
+  if (i2c_master_transmit_receive(dev, &reg, 1, data, length, _timeout_ms) != ESP_OK)
+    return CST816S_ERR_NACK;
+  return CST816S_OK;
+}
+
+/*!
+    @brief  write the register address and data in one transaction
+*/
+uint8_t CST816S_IDFTransport::write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length)
+{
+  if (length >= CST816S_IDF_MAX_WRITE)
+    return CST816S_ERR_LENGTH;
+  i2c_master_dev_handle_t dev = device(addr);
+  if (dev == nullptr)
+    return CST816S_ERR_NACK;
+  uint8_t buffer[CST816S_IDF_MAX_WRITE];
+  buffer[0] = reg;
+  if (length)
+    memcpy(&buffer[1], data, length);
+  if (i2c_master_transmit(dev, buffer, length + 1, _timeout_ms) != ESP_OK)
+    return CST816S_ERR_NACK;
+  return CST816S_OK;
+}
+
+/*!
+    @brief  clock out a stuck slave with the driver's own bus reset
+*/
+bool CST816S_IDFTransport::recover()
+{
+  return i2c_master_bus_reset(_bus) == ESP_OK;
+}
+#elif CST816S_HAL_ARDUINO
+#include <Wire.h>
+
+/*!
+    @brief  Constructor for CST816S_WireTransport
+  @param	wire
+      i2c bus to use
+*/
+CST816S_WireTransport::CST816S_WireTransport(TwoWire &wire)
+{
+  _wire = &wire;
+}
+
+/*!
+    @brief  read data from i2c
+  @param	addr
+      i2c device address
+  @param	reg
+      device register address
+  @param	data
+      array to copy the read data
+  @param	length
+      length of data
+  @return CST816S_OK, CST816S_ERR_NACK or CST816S_ERR_SHORT_READ
+*/
+uint8_t CST816S_WireTransport::read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length)
+{
+  _wire->beginTransmission(addr);
+  _wire->write(reg);
+  if (_wire->endTransmission(true))
+    return CST816S_ERR_NACK;
+  size_t received = _wire->requestFrom((uint16_t)addr, length, true);
+  if (received < length)
+  {
+    // read() would return -1 for the missing bytes, decoded as 0xFF garbage
+    while (_wire->available())
+    {
+      _wire->read();
+    }
+    return CST816S_ERR_SHORT_READ;
+  }
+  for (size_t i = 0; i < length; i++)
+  {
+    *data++ = _wire->read();
+  }
+  return CST816S_OK;
+}
+
+/*!
+    @brief  write data to i2c
+  @param	addr
+      i2c device address
+  @param	reg
+      device register address
+  @param	data
+      data to be sent
+  @param	length
+      length of data
+*/
+uint8_t CST816S_WireTransport::write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length)
+{
+  _wire->beginTransmission(addr);
+  _wire->write(reg);
+  for (size_t i = 0; i < length; i++)
+  {
+    _wire->write(*data++);
+  }
+  if (_wire->endTransmission(true))
+    return CST816S_ERR_NACK;
+  return CST816S_OK;
+}
+#endif
+
+/*!
+    @brief  Constructor for CST816S_MuxTransport
+  @param	bus
+      upstream transport the multiplexer is connected to
+  @param	channel
+      multiplexer channel (0-7) the controller is on
+  @param	mux_address
+      i2c address of the multiplexer
+*/
+CST816S_MuxTransport::CST816S_MuxTransport(CST816S_Transport &bus, uint8_t channel, uint8_t mux_address)
+{
+  _bus = &bus;
+  _channel = channel;
+  _mux_address = mux_address;
+}
+
+/*!
+    @brief  select the channel, then read from the controller
+*/
+uint8_t CST816S_MuxTransport::read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length)
+{
+  uint8_t result = select();
+  if (result)
+    return result;
+  return _bus->read(addr, reg, data, length);
+}
+
+/*!
+    @brief  select the channel, then write to the controller
+*/
+uint8_t CST816S_MuxTransport::write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length)
+{
+  uint8_t result = select();
+  if (result)
+    return result;
+  return _bus->write(addr, reg, data, length);
+}
+
+/*!
+    @brief  write the channel mask to the multiplexer control register
+*/
+uint8_t CST816S_MuxTransport::select()
+{
+  // The control register is the only byte written, so it goes out as "reg"
+  return _bus->write(_mux_address, 1 << _channel, nullptr, 0);
+}
+
+/*!
+    @brief  Constructor for CST816S_ReplayTransport
+  @param	frames
+      recorded report frames, back to back, each starting at register 0x01
+  @param	count
+      number of frames
+  @param	frame_size
+      bytes per frame
+*/
+CST816S_ReplayTransport::CST816S_ReplayTransport(const uint8_t *frames, size_t count, size_t frame_size)
+{
+  _frames = frames;
+  _count = count;
+  _frame_size = frame_size;
+}
+
+/*!
+    @brief  return the next recorded frame for report reads
+*/
+uint8_t CST816S_ReplayTransport::read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length)
+{
+  (void)addr;
+  _reads++;
+  _bytes += length;
+
+  memset(data, 0, length);
+  if (reg != 0x01 || _count == 0)
+  {
+    return 0;
+  }
+
+  const uint8_t *frame = &_frames[_next * _frame_size];
+  memcpy(data, frame, length < _frame_size ? length : _frame_size);
+
+  _played++;
+  if (++_next >= _count)
+  {
+    _next = 0;
+  }
+  return 0;
+}
+
+/*!
+    @brief  accept and count a register write
+*/
+uint8_t CST816S_ReplayTransport::write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length)
+{
+  (void)addr;
+  (void)reg;
+  (void)data;
+  _writes++;
+  _bytes += length;
+  return 0;
+}
+
+/*!
+    @brief  restart playback from the first frame
+*/
+void CST816S_ReplayTransport::rewind()
+{
+  _next = 0;
+  _played = 0;
+}
@@ -0,0 +1,162 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CST816S_TRANSPORT_H
+#define CST816S_TRANSPORT_H
+
+#include "CST816S_HAL.h"
+
+#if CST816S_HAL_IDF
+#include <driver/i2c_master.h>
+#endif
+
+class TwoWire;
+
+// Transfer results returned by transports and the driver's register access
+enum I2C_RESULT {
+  CST816S_OK = 0,
+  CST816S_ERR_NACK,        // address or data not acknowledged
+  CST816S_ERR_SHORT_READ,  // fewer bytes received than requested
+  CST816S_ERR_BAD_FRAME,   // touch report failed validation
+  CST816S_ERR_LENGTH,      // transfer longer than the transport supports
+};
+
+/*!
+    @brief  Register-level bus access used by CST816S
+
+    Implement this to run the driver over a different bus driver, an I2C mux
+    or a simulated controller.
+*/
+class CST816S_Transport {
+  public:
+    virtual ~CST816S_Transport() {}
+    /** @brief Read `length` consecutive registers starting at `reg`. @return CST816S_OK or an I2C_RESULT error */
+    virtual uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) = 0;
+    /** @brief Write `length` consecutive registers starting at `reg`. @return CST816S_OK or an I2C_RESULT error */
+    virtual uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) = 0;
+    /** @brief Free a stuck bus, called before the driver resets the controller. @return true if anything was done */
+    virtual bool recover() { return false; }
+};
+
+#if CST816S_HAL_IDF
+// Cached device handles, one per i2c address used (controller, mux)
+#ifndef CST816S_IDF_DEVICES
+#define CST816S_IDF_DEVICES 2
+#endif
+// Longest register write in one transaction (the config block is 19 bytes)
+#define CST816S_IDF_MAX_WRITE 32
+
+/*!
+    @brief  Transport over the ESP-IDF i2c_master driver
+
+    Uses a bus created by the application with i2c_new_master_bus() and
+    adds a device handle per address on first use. Each register read is a
+    single i2c_master_transmit_receive() transaction.
+*/
+class CST816S_IDFTransport : public CST816S_Transport {
+  public:
+    CST816S_IDFTransport(i2c_master_bus_handle_t bus, uint32_t clock = 400000, int timeout_ms = 10);
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override;
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override;
+    bool recover() override;
+
+  private:
+    i2c_master_bus_handle_t _bus;
+    uint32_t _clock;
+    int _timeout_ms;
+    uint8_t _addresses[CST816S_IDF_DEVICES] = {};
+    i2c_master_dev_handle_t _devices[CST816S_IDF_DEVICES] = {};
+
+    i2c_master_dev_handle_t device(uint8_t addr);
+};
+#elif CST816S_HAL_ARDUINO
+
+/*!
+    @brief  Transport over an Arduino TwoWire bus (the default)
+*/
+class CST816S_WireTransport : public CST816S_Transport {
+  public:
+    explicit CST816S_WireTransport(TwoWire &wire);
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override;
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override;
+
+  private:
+    TwoWire *_wire;
+};
+
+#endif
+
+/*!
+    @brief  Transport behind a TCA9548A-style I2C multiplexer channel
+
+    Selects the channel before every transaction, so several controllers
+    with the same address can share one upstream bus.
+*/
+class CST816S_MuxTransport : public CST816S_Transport {
+  public:
+    CST816S_MuxTransport(CST816S_Transport &bus, uint8_t channel, uint8_t mux_address = 0x70);
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override;
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override;
+    bool recover() override { return _bus->recover(); }
+
+  private:
+    CST816S_Transport *_bus;
+    uint8_t _channel;
+    uint8_t _mux_address;
+
+    uint8_t select();
+};
+
+/*!
+    @brief  Simulated controller that replays recorded touch reports
+
+    Each read of the report block (register 0x01) returns the next recorded
+    frame, wrapping around at the end. Other registers read as zero and
+    writes are accepted and counted. Useful for benchmarks and for running
+    the driver without hardware.
+*/
+class CST816S_ReplayTransport : public CST816S_Transport {
+  public:
+    CST816S_ReplayTransport(const uint8_t *frames, size_t count, size_t frame_size);
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override;
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override;
+    void rewind();
+
+    uint32_t frames_played() const { return _played; }
+    uint32_t reads() const { return _reads; }
+    uint32_t writes() const { return _writes; }
+    uint32_t bytes() const { return _bytes; }
+
+  private:
+    const uint8_t *_frames;
+    size_t _count;
+    size_t _frame_size;
+    size_t _next = 0;
+    uint32_t _played = 0;
+    uint32_t _reads = 0;
+    uint32_t _writes = 0;
+    uint32_t _bytes = 0;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <CST816S.h>
+
+// Recorded report frames (register 0x01 onwards) of a swipe down:
+// GestureID, FingerNum, XposH (event in bits 6-7), XposL, YposH, YposL, pressure, area
+const uint8_t swipe[][CST816S_REPORT_SIZE] = {
+  {0x00, 1, 0x00, 120, 0x00,  40, 0, 0},  // down
+  {0x00, 1, 0x80, 120, 0x00,  80, 0, 0},  // contact
+  {0x00, 1, 0x80, 121, 0x00, 120, 0, 0},
+  {0x00, 1, 0x80, 121, 0x00, 160, 0, 0},
+  {0x00, 1, 0x80, 122, 0x00, 200, 0, 0},
+  {0x02, 0, 0x40, 122, 0x00, 200, 0, 0},  // up, SWIPE_DOWN
+};
+
+const int iterations = 10000;
+
+CST816S_ReplayTransport replay(&swipe[0][0], sizeof(swipe) / sizeof(swipe[0]), CST816S_REPORT_SIZE);
+CST816S touch(-1, -1, replay);  // no reset/irq pins: the replay source drives the event path
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+
+  uint32_t heap_before = ESP.getFreeHeap();
+  uint32_t worst = 0;
+  uint32_t checksum = 0;
+  uint32_t start = micros();
+
+  for (int i = 0; i < iterations; i++) {
+    uint32_t t0 = micros();
+    touch.inject_interrupt();
+    if (touch.available()) {
+      checksum += touch.data.x + touch.data.y + touch.data.gestureID;
+    }
+    uint32_t dt = micros() - t0;
+    if (dt > worst) {
+      worst = dt;
+    }
+  }
+
+  uint32_t elapsed = micros() - start;
+  int32_t heap_delta = (int32_t)heap_before - (int32_t)ESP.getFreeHeap();
+
+  Serial.print("Events: ");
+  Serial.println(replay.frames_played());
+  Serial.print("Throughput (events/s): ");
+  Serial.println((uint32_t)(iterations * 1000000ULL / elapsed));
+  Serial.print("Avg latency (us): ");
+  Serial.println(elapsed / iterations);
+  Serial.print("Max latency (us): ");
+  Serial.println(worst);
+  Serial.print("Heap delta (bytes): ");
+  Serial.println(heap_delta);
+  Serial.print("Checksum: ");
+  Serial.println(checksum);
+
+#if CST816S_STATS
+  touch_stats stats = touch.stats();
+  Serial.print("IRQ-to-consume p99 (us): ");
+  Serial.println(stats.latency_p99);
+  Serial.print("Report read avg (us): ");
+  Serial.println(stats.read_avg);
+  Serial.print("Bytes transferred: ");
+  Serial.println(stats.bytes);
+#endif
+}
+
+void loop() {
+}
@@ -0,0 +1,64 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// ESP32 only: deep sleep until a double-tap, then resume without resetting
+// the touch controller and handle the tap that woke us.
+
+#include <CST816S.h>
+
+CST816S touch(21, 22, 5, 4);	// sda, scl, rst, irq
+
+void setup() {
+  Serial.begin(115200);
+
+  if (!touch.resume()) {
+    Serial.println("Touch controller not responding");
+  }
+
+  // The wake-up report is already queued
+  if (touch.available()) {
+    Serial.print("Woken by: ");
+    Serial.println(touch.gesture());
+  }
+
+  touch.set_power_mode(POWER_ACTIVE);
+}
+
+void loop() {
+  static uint32_t lastTouch = millis();
+
+  if (touch.available()) {
+    lastTouch = millis();
+    Serial.println(touch.gesture());
+  }
+
+  // Go to sleep after 10 seconds without touches
+  if (millis() - lastTouch > 10000) {
+    Serial.println("Sleeping, double-tap to wake");
+    Serial.flush();
+    touch.set_power_mode(POWER_IDLE_GESTURE_ONLY);
+    touch.prepare_sleep(true);
+    esp_deep_sleep_start();
+  }
+}
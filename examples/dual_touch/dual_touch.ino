@@ -0,0 +1,63 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Two touch controllers on separate buses, serviced together
+
+#include <Wire.h>
+#include <CST816S.h>
+#include <CST816S_Bus.h>
+
+CST816S left(21, 22, 5, 4);                                  // sda, scl, rst, irq on Wire
+CST816S right(25, 26, 27, 14, Wire1, CST816S_I2C_FAST_MODE);  // same on Wire1 at 400 kHz
+CST816S_Bus touchBus;
+
+void print(const char *name, CST816S &touch) {
+  Serial.print(name);
+  Serial.print("\t");
+  Serial.print(touch.data.x);
+  Serial.print("\t");
+  Serial.println(touch.data.y);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  left.begin();
+  right.begin();
+
+  touchBus.add(left);
+  touchBus.add(right);
+}
+
+void loop() {
+  // Reads every pending report in one pass
+  touchBus.service();
+
+  while (left.available()) {
+    print("Left", left);
+  }
+  while (right.available()) {
+    print("Right", right);
+  }
+}
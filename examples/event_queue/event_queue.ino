@@ -0,0 +1,59 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <CST816S.h>
+
+CST816S touch(21, 22, 5, 4);	// sda, scl, rst, irq
+
+touch_event events[CST816S_EVENT_QUEUE_SIZE];
+
+void setup() {
+  Serial.begin(115200);
+  touch.begin();
+}
+
+void loop() {
+  // Simulate a slow frame, capturing touch reports while we work
+  for (int i = 0; i < 10; i++) {
+    delay(5);
+    touch.service();
+  }
+
+  // Process everything that arrived during the frame in one burst
+  size_t count = touch.read_events(events, CST816S_EVENT_QUEUE_SIZE);
+  for (size_t i = 0; i < count; i++) {
+    Serial.print(events[i].timestamp);
+    Serial.print("\t");
+    Serial.print(events[i].event);
+    Serial.print("\t");
+    Serial.print(events[i].x);
+    Serial.print("\t");
+    Serial.println(events[i].y);
+  }
+
+  if (touch.dropped_events()) {
+    Serial.print("Dropped: ");
+    Serial.println(touch.dropped_events());
+  }
+}
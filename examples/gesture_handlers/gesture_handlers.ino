@@ -0,0 +1,63 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <CST816S.h>
+
+CST816S touch(21, 22, 5, 4);	// sda, scl, rst, irq
+
+int brightness = 128;
+
+void setup() {
+  Serial.begin(115200);
+  touch.begin();
+
+  touch.on_event(0, [](const touch_event &e) {
+    Serial.print("Down at ");
+    Serial.print(e.x);
+    Serial.print(",");
+    Serial.println(e.y);
+  });
+  touch.on_event(1, [](const touch_event &e) {
+    Serial.println("Up");
+  });
+
+  touch.on_gesture(SWIPE_UP, [](const touch_event &e) {
+    if (brightness <= 223) brightness += 32;
+    Serial.print("Brightness ");
+    Serial.println(brightness);
+  });
+  touch.on_gesture(SWIPE_DOWN, [](const touch_event &e) {
+    if (brightness >= 32) brightness -= 32;
+    Serial.print("Brightness ");
+    Serial.println(brightness);
+  });
+  touch.on_gesture(LONG_PRESS, [](const touch_event &e) {
+    Serial.println("Long press: menu");
+  });
+}
+
+void loop() {
+  // Handlers run here, in loop() context, after the reports were read
+  touch.dispatch();
+}
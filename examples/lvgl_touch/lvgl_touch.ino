@@ -0,0 +1,53 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <lvgl.h>
+#include <CST816S.h>
+#include <CST816S_LVGL.h>
+
+CST816S touch(21, 22, 5, 4);	// sda, scl, rst, irq
+CST816S_LVGL touch_indev(touch);
+
+void setup() {
+  Serial.begin(115200);
+
+  lv_init();
+  // ... create the LVGL display for your panel here ...
+
+  touch.set_coalescing(false);  // let LVGL see every sample of a drag
+#if defined(ESP32)
+  touch.begin_task();           // reports are read off the LVGL thread
+#else
+  touch.begin();
+#endif
+  touch_indev.begin();
+}
+
+void loop() {
+#if !defined(ESP32)
+  touch.service();              // read pending reports before LVGL runs
+#endif
+  lv_timer_handler();
+  delay(5);
+}
@@ -0,0 +1,104 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <CST816S.h>
+#include <CST816S_Recorder.h>
+#include <LittleFS.h>
+
+CST816S touch(21, 22, 5, 4);	// sda, scl, rst, irq
+
+uint8_t ring[1024];
+CST816S_Recorder recorder(ring, sizeof(ring));
+File file;
+
+const uint32_t record_ms = 20000;
+uint32_t started;
+uint32_t last_flush;
+
+void replay() {
+  file = LittleFS.open("/touch.rec", "r");
+  size_t length = file.size();
+  uint8_t *recording = (uint8_t *)malloc(length);
+  file.read(recording, length);
+  file.close();
+
+  // A second driver instance whose "controller" is the recording. The
+  // reports go through the same decode and queue path as live input.
+  CST816S_Player player(recording, length);
+  CST816S replayed(-1, -1, player);
+
+  while (!player.finished()) {
+    player.update(replayed);
+    touch_event event;
+    while (replayed.pop(event)) {
+      Serial.print(event.timestamp);
+      Serial.print("\t");
+      Serial.print(event.event);
+      Serial.print("\t");
+      Serial.print(event.x);
+      Serial.print("\t");
+      Serial.println(event.y);
+    }
+  }
+  Serial.print("Replayed reports: ");
+  Serial.println(player.frames_played());
+  free(recording);
+}
+
+void setup() {
+  Serial.begin(115200);
+  LittleFS.begin(true);
+  file = LittleFS.open("/touch.rec", "w");
+
+  touch.begin();
+  touch.set_recorder(&recorder);
+  recorder.start();
+  started = last_flush = millis();
+  Serial.println("Recording touches for 20 s");
+}
+
+void loop() {
+  if (!recorder.recording()) {
+    return;
+  }
+
+  touch.available();
+
+  // One file write per second instead of one per report
+  if (millis() - last_flush > 1000) {
+    recorder.flush(file);
+    last_flush = millis();
+  }
+
+  if (millis() - started > record_ms) {
+    recorder.stop();
+    recorder.flush(file);
+    file.close();
+    Serial.print("Recorded reports: ");
+    Serial.print(recorder.frames());
+    Serial.print(", dropped: ");
+    Serial.println(recorder.dropped());
+    replay();
+  }
+}
@@ -0,0 +1,74 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <CST816S.h>
+#include <CST816S_Gesture.h>
+
+CST816S touch(21, 22, 5, 4);	// sda, scl, rst, irq
+CST816S_Gesture gestures;
+
+void report(const gesture_event &result) {
+  if (result.gesture != NONE) {
+    Serial.print(CST816S::gesture_name(result.gesture));
+    Serial.print("\tvx: ");
+    Serial.print(result.vx);
+    Serial.print("\tvy: ");
+    Serial.println(result.vy);
+  } else if (result.drag) {
+    Serial.print("Drag\tdx: ");
+    Serial.print(result.dx);
+    Serial.print("\tdy: ");
+    Serial.println(result.dy);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  touch.begin();
+
+  // Hardware gesture detection off, interrupt on touch and coordinate change
+  touch.begin_config();
+  touch.set_motion_mask(0x00);
+  touch.set_irq_control(0x60);
+  touch.apply_config();
+
+  gestures.set_double_tap_window(250);
+  gestures.set_long_press_time(600);
+}
+
+void loop() {
+  touch_event event;
+  gesture_event result;
+
+  while (touch.pop(event)) {
+    if (gestures.update(event, result)) {
+      report(result);
+    }
+  }
+
+  // Long presses and single taps (after the double-tap window) are time based
+  if (gestures.poll(micros(), result)) {
+    report(result);
+  }
+}
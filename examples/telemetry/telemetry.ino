@@ -0,0 +1,78 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+#include <CST816S.h>
+
+// Telemetry is compiled out by default: build with -DCST816S_TELEMETRY=1
+// (e.g. build_flags in PlatformIO) so the library and this sketch see it
+
+CST816S touch(21, 22, 5, 4);  // sda, scl, rst, irq
+
+// How often the counters are shipped; the backend diffs successive records
+#define REPORT_INTERVAL_MS 60000
+
+uint32_t last_report = 0;
+
+void setup() {
+  Serial.begin(115200);
+  touch.begin();
+}
+
+void loop() {
+  while (touch.available()) {
+    // application touch handling
+  }
+
+#if CST816S_TELEMETRY
+  if (millis() - last_report >= REPORT_INTERVAL_MS) {
+    last_report = millis();
+
+    // Stand-in for the uplink: print the packed record as hex
+    uint8_t record[CST816S_TELEMETRY_SIZE];
+    size_t length = touch.telemetry_pack(record, sizeof(record));
+    Serial.print("Telemetry (");
+    Serial.print(length);
+    Serial.print(" bytes): ");
+    for (size_t i = 0; i < length; i++) {
+      if (record[i] < 0x10) Serial.print('0');
+      Serial.print(record[i], HEX);
+    }
+    Serial.println();
+
+    touch_telemetry t = touch.telemetry();
+    Serial.print("Touches: ");
+    Serial.print(t.touches);
+    Serial.print("\tI2C errors: ");
+    Serial.print(t.i2c.errors);
+    Serial.print("\tIRQs: ");
+    Serial.print(t.irq.irqs);
+    Serial.print("\tActive ms: ");
+    Serial.println(t.power_time[POWER_ACTIVE]);
+  }
+#else
+  if (millis() - last_report >= REPORT_INTERVAL_MS) {
+    last_report = millis();
+    Serial.println("Build with -DCST816S_TELEMETRY=1 to enable telemetry");
+  }
+#endif
+}
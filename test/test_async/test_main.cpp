@@ -0,0 +1,137 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// read_async() results and failures, without the acquisition task.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+static const uint8_t good[CST816S_REPORT_SIZE] = {0x00, 1, 0x00, 120, 0x00, 40, 0, 0};
+static const uint8_t garbage[CST816S_REPORT_SIZE] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// Transport whose every transfer is NACKed
+class DeadTransport : public CST816S_Transport {
+  public:
+    uint8_t read(uint8_t, uint8_t, uint8_t *data, size_t length) override
+    {
+      memset(data, 0, length);
+      return CST816S_ERR_NACK;
+    }
+    uint8_t write(uint8_t, uint8_t, const uint8_t *, size_t) override
+    {
+      return CST816S_ERR_NACK;
+    }
+};
+
+static int callbacks;
+
+void setUp()
+{
+  callbacks = 0;
+}
+
+void tearDown()
+{
+}
+
+static void count_callback(const touch_event &event)
+{
+  (void)event;
+  callbacks++;
+}
+
+void test_result_is_delivered()
+{
+  CST816S_ReplayTransport replay(good, 1, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+
+  TEST_ASSERT_TRUE(touch.read_async(count_callback));
+  TEST_ASSERT_EQUAL(1, callbacks);
+
+  touch_event event;
+  TEST_ASSERT_EQUAL(CST816S_OK, touch.read_async_error());
+  TEST_ASSERT_TRUE(touch.read_async_done(event));
+  TEST_ASSERT_EQUAL(120, event.x);
+  TEST_ASSERT_EQUAL(40, event.y);
+  TEST_ASSERT_FALSE(touch.read_async_done(event));
+}
+
+void test_transfer_failure_is_reported()
+{
+  DeadTransport bus;
+  CST816S touch(-1, -1, bus);
+  touch.set_retries(0, false);
+
+  TEST_ASSERT_TRUE(touch.read_async(count_callback));
+  TEST_ASSERT_EQUAL(0, callbacks);
+
+  touch_event event;
+  TEST_ASSERT_FALSE(touch.read_async_done(event));
+  TEST_ASSERT_EQUAL(CST816S_ERR_NACK, touch.read_async_error());
+  // Reported once, then the read is no longer outstanding
+  TEST_ASSERT_EQUAL(CST816S_OK, touch.read_async_error());
+  TEST_ASSERT_FALSE(touch.read_async_done(event));
+}
+
+void test_rejected_report_is_reported()
+{
+  CST816S_ReplayTransport replay(garbage, 1, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+
+  TEST_ASSERT_TRUE(touch.read_async(count_callback));
+  TEST_ASSERT_EQUAL(0, callbacks);
+  TEST_ASSERT_EQUAL(CST816S_ERR_BAD_FRAME, touch.read_async_error());
+}
+
+void test_read_can_restart_after_failure()
+{
+  const uint8_t frames[][CST816S_REPORT_SIZE] = {
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+    {0x00, 1, 0x00, 120, 0x00, 40, 0, 0},
+  };
+  CST816S_ReplayTransport replay(&frames[0][0], 2, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+
+  TEST_ASSERT_TRUE(touch.read_async(count_callback));
+  TEST_ASSERT_TRUE(touch.read_async(count_callback));
+  TEST_ASSERT_EQUAL(1, callbacks);
+
+  touch_event event;
+  TEST_ASSERT_EQUAL(CST816S_OK, touch.read_async_error());
+  TEST_ASSERT_TRUE(touch.read_async_done(event));
+  TEST_ASSERT_EQUAL(120, event.x);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_result_is_delivered);
+  RUN_TEST(test_transfer_failure_is_reported);
+  RUN_TEST(test_rejected_report_is_reported);
+  RUN_TEST(test_read_can_restart_after_failure);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Fast boot paths against a controller that never answers.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+// Transport whose every transfer is NACKed
+class DeadTransport : public CST816S_Transport {
+  public:
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override
+    {
+      (void)addr;
+      (void)reg;
+      memset(data, 0, length);
+      reads++;
+      return CST816S_ERR_NACK;
+    }
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override
+    {
+      (void)addr;
+      (void)reg;
+      (void)data;
+      (void)length;
+      writes++;
+      return CST816S_ERR_NACK;
+    }
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+};
+
+static const int rst_pin = 5;
+static const uint32_t timeout = 20;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_begin_fast_timeout_is_bounded()
+{
+  DeadTransport bus;
+  CST816S touch(rst_pin, -1, bus);
+
+  uint32_t start = cst816s_millis();
+  TEST_ASSERT_FALSE(touch.begin_fast(CST816S_RISING, timeout));
+  uint32_t elapsed = cst816s_millis() - start;
+
+  TEST_ASSERT_TRUE(elapsed < timeout + CST816S_RESET_PULSE_MS + 10);
+  TEST_ASSERT_EQUAL(CHIP_UNKNOWN, touch.chip());
+  TEST_ASSERT_EQUAL(0, touch.health().recoveries);
+}
+
+void test_begin_async_poll_never_blocks()
+{
+  DeadTransport bus;
+  CST816S touch(rst_pin, -1, bus);
+
+  touch.begin_async(CST816S_RISING, timeout);
+  uint32_t start = cst816s_millis();
+  uint32_t worst = 0;
+  uint32_t calls = 0;
+  BOOT_STATE state;
+  do
+  {
+    uint32_t t0 = cst816s_micros();
+    state = touch.begin_async_poll();
+    uint32_t dt = cst816s_micros() - t0;
+    if (dt > worst)
+    {
+      worst = dt;
+    }
+    calls++;
+  } while (state < BOOT_READY && cst816s_millis() - start < 1000);
+  uint32_t elapsed = cst816s_millis() - start;
+
+  TEST_ASSERT_EQUAL(BOOT_TIMEOUT, state);
+  TEST_ASSERT_TRUE(elapsed < timeout + CST816S_RESET_PULSE_MS + 10);
+  TEST_ASSERT_TRUE(worst < 5000);
+  TEST_ASSERT_EQUAL(0, touch.health().recoveries);
+
+  // The chip ID probe is rate limited, not repeated on every call
+  TEST_ASSERT_TRUE(calls > 100);
+  TEST_ASSERT_TRUE(bus.reads <= timeout / CST816S_BOOT_PROBE_MS + 2);
+  TEST_ASSERT_TRUE(bus.reads >= 2);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_fast_timeout_is_bounded);
+  RUN_TEST(test_begin_async_poll_never_blocks);
+  return UNITY_END();
+}
@@ -0,0 +1,129 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Coalescing and the change threshold on a swipe whose contact samples
+// repeat the GestureID, as the controller reports them.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+static const uint8_t swipe[][CST816S_REPORT_SIZE] = {
+  {0x00, 1, 0x00, 120, 0x00,  40, 0, 0},  // down
+  {0x00, 1, 0x80, 120, 0x00,  80, 0, 0},  // contact
+  {0x00, 1, 0x80, 120, 0x00, 120, 0, 0},
+  {0x02, 1, 0x80, 120, 0x00, 160, 0, 0},  // contact, SWIPE_DOWN from here on
+  {0x02, 1, 0x80, 120, 0x00, 200, 0, 0},
+  {0x02, 1, 0x80, 120, 0x00, 240, 0, 0},
+  {0x02, 0, 0x40, 120, 0x00, 240, 0, 0},  // up
+};
+
+static const size_t frame_count = sizeof(swipe) / sizeof(swipe[0]);
+
+static CST816S_ReplayTransport *replay;
+static CST816S *touch;
+
+void setUp()
+{
+  replay = new CST816S_ReplayTransport(&swipe[0][0], frame_count, CST816S_REPORT_SIZE);
+  touch = new CST816S(-1, -1, *replay);
+}
+
+void tearDown()
+{
+  delete touch;
+  delete replay;
+}
+
+// Queue the whole swipe, then drain it; returns the number of samples delivered
+static size_t drain(int *y, uint8_t *gesture, uint8_t *event)
+{
+  for (size_t i = 0; i < frame_count; i++)
+  {
+    touch->inject_interrupt();
+    touch->service();
+  }
+  size_t n = 0;
+  while (n < frame_count && touch->available())
+  {
+    y[n] = touch->data.y;
+    gesture[n] = touch->data.gestureID;
+    event[n] = touch->data.event;
+    n++;
+  }
+  return n;
+}
+
+void test_without_coalescing_every_sample_is_delivered()
+{
+  int y[frame_count];
+  uint8_t gesture[frame_count], event[frame_count];
+  TEST_ASSERT_EQUAL(frame_count, drain(y, gesture, event));
+}
+
+void test_swipe_samples_coalesce()
+{
+  touch->set_coalescing(true);
+  int y[frame_count];
+  uint8_t gesture[frame_count], event[frame_count];
+
+  TEST_ASSERT_EQUAL(5, drain(y, gesture, event));
+  TEST_ASSERT_EQUAL(0, event[0]);
+  TEST_ASSERT_EQUAL(40, y[0]);
+  // Plain contact samples merge into the newest one
+  TEST_ASSERT_EQUAL(2, event[1]);
+  TEST_ASSERT_EQUAL(120, y[1]);
+  TEST_ASSERT_EQUAL(NONE, gesture[1]);
+  // The first SWIPE_DOWN sample is a boundary
+  TEST_ASSERT_EQUAL(160, y[2]);
+  TEST_ASSERT_EQUAL(SWIPE_DOWN, gesture[2]);
+  // The samples repeating it merge like plain ones
+  TEST_ASSERT_EQUAL(240, y[3]);
+  TEST_ASSERT_EQUAL(SWIPE_DOWN, gesture[3]);
+  TEST_ASSERT_EQUAL(1, event[4]);
+}
+
+void test_change_threshold_applies_to_repeated_gesture()
+{
+  touch->set_min_delta(100);
+  int y[frame_count];
+  uint8_t gesture[frame_count], event[frame_count];
+
+  TEST_ASSERT_EQUAL(3, drain(y, gesture, event));
+  TEST_ASSERT_EQUAL(0, event[0]);
+  TEST_ASSERT_EQUAL(160, y[1]);
+  TEST_ASSERT_EQUAL(SWIPE_DOWN, gesture[1]);
+  TEST_ASSERT_EQUAL(1, event[2]);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_without_coalescing_every_sample_is_delivered);
+  RUN_TEST(test_swipe_samples_coalesce);
+  RUN_TEST(test_change_threshold_applies_to_repeated_gesture);
+  return UNITY_END();
+}
@@ -0,0 +1,176 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Shadow configuration table: skipped redundant writes and burst grouping.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+// Keeps a register file and logs each write transaction
+class BurstTransport : public CST816S_Transport {
+  public:
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override
+    {
+      (void)addr;
+      for (size_t i = 0; i < length; i++)
+      {
+        data[i] = regs[(reg + i) & 0xFF];
+      }
+      return CST816S_OK;
+    }
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override
+    {
+      (void)addr;
+      if (fail_writes)
+      {
+        return CST816S_ERR_NACK;
+      }
+      if (bursts < 8)
+      {
+        first[bursts] = reg;
+        lengths[bursts] = length;
+      }
+      bursts++;
+      for (size_t i = 0; i < length; i++)
+      {
+        regs[(reg + i) & 0xFF] = data[i];
+      }
+      return CST816S_OK;
+    }
+
+    bool fail_writes = false;
+    uint8_t regs[256] = {};
+    int bursts = 0;
+    uint8_t first[8] = {};
+    size_t lengths[8] = {};
+};
+
+static BurstTransport *bus;
+static CST816S *touch;
+
+void setUp()
+{
+  bus = new BurstTransport();
+  touch = new CST816S(-1, -1, *bus);
+  touch->set_retries(0, false);
+}
+
+void tearDown()
+{
+  delete touch;
+  delete bus;
+}
+
+void test_unchanged_value_is_not_rewritten()
+{
+  touch->set_auto_sleep_time(7);
+  TEST_ASSERT_EQUAL(1, bus->bursts);
+  TEST_ASSERT_EQUAL(7, bus->regs[0xF9]);
+
+  touch->set_auto_sleep_time(7);
+  TEST_ASSERT_EQUAL(1, bus->bursts);
+
+  touch->set_auto_sleep_time(9);
+  TEST_ASSERT_EQUAL(2, bus->bursts);
+  TEST_ASSERT_EQUAL(9, bus->regs[0xF9]);
+}
+
+void test_batch_is_deferred_until_apply()
+{
+  touch->begin_config();
+  touch->set_motion_mask(0x01);
+  touch->set_auto_sleep_time(5);
+  touch->set_irq_control(0x10);
+  TEST_ASSERT_EQUAL(0, bus->bursts);
+
+  TEST_ASSERT_EQUAL(CST816S_OK, touch->apply_config());
+  // 0xF9 and 0xFA are adjacent; the unknown registers after 0xEC split it off
+  TEST_ASSERT_EQUAL(2, bus->bursts);
+  TEST_ASSERT_EQUAL(0xEC, bus->first[0]);
+  TEST_ASSERT_EQUAL_size_t(1, bus->lengths[0]);
+  TEST_ASSERT_EQUAL(0xF9, bus->first[1]);
+  TEST_ASSERT_EQUAL_size_t(2, bus->lengths[1]);
+  TEST_ASSERT_EQUAL(0x01, bus->regs[0xEC]);
+  TEST_ASSERT_EQUAL(5, bus->regs[0xF9]);
+  TEST_ASSERT_EQUAL(0x10, bus->regs[0xFA]);
+
+  // Nothing left to flush
+  TEST_ASSERT_EQUAL(CST816S_OK, touch->apply_config());
+  TEST_ASSERT_EQUAL(2, bus->bursts);
+}
+
+// Once the table is loaded, clean registers are rewritten to join bursts,
+// but never the scan references at 0xF0-0xF3
+void test_known_registers_join_bursts()
+{
+  bus->regs[0xF0] = 0x55;
+  TEST_ASSERT_EQUAL(CST816S_OK, touch->load_config());
+
+  touch->begin_config();
+  touch->set_auto_sleep_time(3);
+  touch->disable_auto_sleep();
+  TEST_ASSERT_EQUAL(CST816S_OK, touch->apply_config());
+  TEST_ASSERT_EQUAL(1, bus->bursts);
+  TEST_ASSERT_EQUAL(0xF9, bus->first[0]);
+  TEST_ASSERT_EQUAL_size_t(0xFE - 0xF9 + 1, bus->lengths[0]);
+
+  bus->bursts = 0;
+  touch->begin_config();
+  touch->set_motion_mask(0x05);
+  touch->set_auto_sleep_time(4);
+  TEST_ASSERT_EQUAL(CST816S_OK, touch->apply_config());
+  TEST_ASSERT_EQUAL(2, bus->bursts);
+  TEST_ASSERT_EQUAL(0xEC, bus->first[0]);
+  TEST_ASSERT_EQUAL_size_t(1, bus->lengths[0]);
+  TEST_ASSERT_EQUAL(0xF9, bus->first[1]);
+  TEST_ASSERT_EQUAL_size_t(1, bus->lengths[1]);
+  TEST_ASSERT_EQUAL(0x55, bus->regs[0xF0]);
+}
+
+void test_failed_burst_stays_dirty()
+{
+  touch->begin_config();
+  touch->set_irq_control(0x60);
+  bus->fail_writes = true;
+  TEST_ASSERT_EQUAL(CST816S_ERR_NACK, touch->apply_config());
+  TEST_ASSERT_EQUAL(0, bus->regs[0xFA]);
+
+  bus->fail_writes = false;
+  TEST_ASSERT_EQUAL(CST816S_OK, touch->apply_config());
+  TEST_ASSERT_EQUAL(1, bus->bursts);
+  TEST_ASSERT_EQUAL(0x60, bus->regs[0xFA]);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_unchanged_value_is_not_rewritten);
+  RUN_TEST(test_batch_is_deferred_until_apply);
+  RUN_TEST(test_known_registers_join_bursts);
+  RUN_TEST(test_failed_burst_stays_dirty);
+  return UNITY_END();
+}
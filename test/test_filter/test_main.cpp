@@ -0,0 +1,158 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// CST816S_Filter debounce, driven directly with touch_event samples.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+#include <CST816S_Filter.h>
+
+static CST816S_Filter filter;
+
+void setUp()
+{
+  filter = CST816S_Filter();
+  filter.set_debounce(20000);
+}
+
+void tearDown()
+{
+}
+
+static touch_event sample(uint32_t timestamp, uint8_t event, uint8_t gesture = NONE)
+{
+  touch_event e = {};
+  e.timestamp = timestamp;
+  e.gestureID = gesture;
+  e.points = event == 1 ? 0 : 1;
+  e.event = event;
+  e.x = 100;
+  e.y = 50;
+  e.point[0].event = event;
+  e.point[0].x = e.x;
+  e.point[0].y = e.y;
+  return e;
+}
+
+void test_short_tap_is_dropped()
+{
+  touch_event e = sample(1000, 0);
+  TEST_ASSERT_FALSE(filter.apply(e));
+  e = sample(11000, 1);
+  TEST_ASSERT_FALSE(filter.apply(e));
+  TEST_ASSERT_FALSE(filter.release(e));
+  TEST_ASSERT_EQUAL(1, filter.rejected_touches());
+}
+
+void test_contact_after_debounce_becomes_down()
+{
+  touch_event e = sample(1000, 0);
+  TEST_ASSERT_FALSE(filter.apply(e));
+  e = sample(11000, 2);
+  TEST_ASSERT_FALSE(filter.apply(e));
+  e = sample(26000, 2);
+  TEST_ASSERT_TRUE(filter.apply(e));
+  TEST_ASSERT_EQUAL(0, e.event);
+  e = sample(40000, 1);
+  TEST_ASSERT_TRUE(filter.apply(e));
+  TEST_ASSERT_EQUAL(1, e.event);
+  TEST_ASSERT_FALSE(filter.release(e));
+  TEST_ASSERT_EQUAL(0, filter.rejected_touches());
+}
+
+// A press the controller reports only as down and up, with no contact samples
+void test_held_press_without_contact_delivers_down_then_up()
+{
+  touch_event e = sample(1000, 0);
+  TEST_ASSERT_FALSE(filter.apply(e));
+
+  e = sample(300000, 1, LONG_PRESS);
+  TEST_ASSERT_TRUE(filter.apply(e));
+  TEST_ASSERT_EQUAL(0, e.event);
+  TEST_ASSERT_EQUAL(NONE, e.gestureID);
+  TEST_ASSERT_EQUAL(1, e.points);
+  TEST_ASSERT_EQUAL(100, e.x);
+  TEST_ASSERT_EQUAL(50, e.y);
+
+  TEST_ASSERT_TRUE(filter.release(e));
+  TEST_ASSERT_EQUAL(1, e.event);
+  TEST_ASSERT_EQUAL(LONG_PRESS, e.gestureID);
+  TEST_ASSERT_EQUAL(300000, e.timestamp);
+  TEST_ASSERT_FALSE(filter.release(e));
+  TEST_ASSERT_EQUAL(0, filter.rejected_touches());
+
+  // The release ended the touch: the next sample starts a new one
+  e = sample(400000, 0);
+  TEST_ASSERT_FALSE(filter.apply(e));
+}
+
+void test_held_press_without_gesture_is_kept()
+{
+  touch_event e = sample(1000, 0);
+  TEST_ASSERT_FALSE(filter.apply(e));
+  e = sample(30000, 1);
+  TEST_ASSERT_TRUE(filter.apply(e));
+  TEST_ASSERT_EQUAL(0, e.event);
+  TEST_ASSERT_TRUE(filter.release(e));
+  TEST_ASSERT_EQUAL(1, e.event);
+  TEST_ASSERT_EQUAL(0, filter.rejected_touches());
+}
+
+// Through the driver: both events reach the queue, in order
+void test_held_press_reaches_the_queue()
+{
+  static const uint8_t frames[][CST816S_REPORT_SIZE] = {
+    {0x00, 1, 0x00, 100, 0x00, 50, 0, 0},  // down
+    {0x0C, 0, 0x40, 100, 0x00, 50, 0, 0},  // up, LONG_PRESS
+  };
+  CST816S_ReplayTransport replay(&frames[0][0], 2, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+  touch.set_filter(&filter);
+
+  touch.inject_interrupt();
+  TEST_ASSERT_FALSE(touch.available());
+
+  cst816s_delay(25);
+  touch.inject_interrupt();
+  TEST_ASSERT_TRUE(touch.available());
+  TEST_ASSERT_EQUAL(0, touch.data.event);
+  TEST_ASSERT_TRUE(touch.available());
+  TEST_ASSERT_EQUAL(1, touch.data.event);
+  TEST_ASSERT_EQUAL(LONG_PRESS, touch.data.gestureID);
+  TEST_ASSERT_FALSE(touch.available());
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_short_tap_is_dropped);
+  RUN_TEST(test_contact_after_debounce_becomes_down);
+  RUN_TEST(test_held_press_without_contact_delivers_down_then_up);
+  RUN_TEST(test_held_press_without_gesture_is_kept);
+  RUN_TEST(test_held_press_reaches_the_queue);
+  return UNITY_END();
+}
@@ -0,0 +1,144 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// CST816S_Gesture recognizer, driven directly with touch_event samples.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+#include <CST816S_Gesture.h>
+
+static CST816S_Gesture recognizer;
+static gesture_event result;
+
+void setUp()
+{
+  recognizer = CST816S_Gesture();
+  result = gesture_event();
+}
+
+void tearDown()
+{
+}
+
+static touch_event sample(uint32_t timestamp, uint8_t event, int x, int y)
+{
+  touch_event e = {};
+  e.timestamp = timestamp;
+  e.points = event == 1 ? 0 : 1;
+  e.event = event;
+  e.x = x;
+  e.y = y;
+  return e;
+}
+
+// Feed a sample and return the gesture it produced, -1 for none
+static int feed(uint32_t timestamp, uint8_t event, int x, int y)
+{
+  return recognizer.update(sample(timestamp, event, x, y), result) ? result.gesture : -1;
+}
+
+// Count the taps reported while feeding a tap at (x, y) starting at t
+static int tap(uint32_t t, int x, int y)
+{
+  int taps = feed(t, 0, x, y) == SINGLE_CLICK;
+  taps += feed(t + 50000, 1, x, y) == SINGLE_CLICK;
+  return taps;
+}
+
+void test_single_tap_after_window()
+{
+  TEST_ASSERT_EQUAL(0, tap(0, 100, 100));
+  TEST_ASSERT_FALSE(recognizer.poll(300000, result));
+  TEST_ASSERT_TRUE(recognizer.poll(400000, result));
+  TEST_ASSERT_EQUAL(SINGLE_CLICK, result.gesture);
+  TEST_ASSERT_EQUAL(100, result.x);
+  TEST_ASSERT_FALSE(recognizer.poll(500000, result));
+}
+
+void test_double_tap()
+{
+  TEST_ASSERT_EQUAL(0, tap(0, 100, 100));
+  TEST_ASSERT_EQUAL(DOUBLE_CLICK, feed(150000, 0, 104, 98));
+  TEST_ASSERT_EQUAL(-1, feed(200000, 1, 104, 98));
+  TEST_ASSERT_FALSE(recognizer.poll(1000000, result));
+}
+
+void test_tap_then_far_tap_reports_two_taps()
+{
+  TEST_ASSERT_EQUAL(0, tap(0, 20, 20));
+
+  // Second tap inside the window but outside the double-tap slop
+  TEST_ASSERT_EQUAL(SINGLE_CLICK, feed(150000, 0, 200, 200));
+  TEST_ASSERT_EQUAL(20, result.x);
+  TEST_ASSERT_EQUAL(20, result.y);
+  TEST_ASSERT_EQUAL(-1, feed(200000, 1, 200, 200));
+
+  TEST_ASSERT_TRUE(recognizer.poll(600000, result));
+  TEST_ASSERT_EQUAL(SINGLE_CLICK, result.gesture);
+  TEST_ASSERT_EQUAL(200, result.x);
+  TEST_ASSERT_EQUAL(200, result.y);
+}
+
+void test_tap_then_swipe_reports_tap_first()
+{
+  tap(0, 100, 100);
+  TEST_ASSERT_EQUAL(SINGLE_CLICK, feed(150000, 0, 100, 200));
+  TEST_ASSERT_EQUAL(-1, feed(160000, 2, 100, 200));
+  TEST_ASSERT_EQUAL(NONE, feed(170000, 2, 130, 200));
+  TEST_ASSERT_EQUAL(SWIPE_RIGHT, feed(180000, 2, 180, 200));
+  TEST_ASSERT_EQUAL(-1, feed(190000, 1, 180, 200));
+  TEST_ASSERT_FALSE(recognizer.poll(1000000, result));
+}
+
+void test_long_press()
+{
+  TEST_ASSERT_EQUAL(-1, feed(0, 0, 100, 100));
+  TEST_ASSERT_FALSE(recognizer.poll(700000, result));
+  TEST_ASSERT_TRUE(recognizer.poll(800000, result));
+  TEST_ASSERT_EQUAL(LONG_PRESS, result.gesture);
+  TEST_ASSERT_EQUAL(-1, feed(900000, 1, 100, 100));
+  TEST_ASSERT_FALSE(recognizer.poll(2000000, result));
+}
+
+void test_tap_without_double_tap_window()
+{
+  recognizer.set_double_tap_window(0);
+  TEST_ASSERT_EQUAL(-1, feed(0, 0, 100, 100));
+  TEST_ASSERT_EQUAL(SINGLE_CLICK, feed(50000, 1, 100, 100));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_single_tap_after_window);
+  RUN_TEST(test_double_tap);
+  RUN_TEST(test_tap_then_far_tap_reports_two_taps);
+  RUN_TEST(test_tap_then_swipe_reports_tap_first);
+  RUN_TEST(test_long_press);
+  RUN_TEST(test_tap_without_double_tap_window);
+  return UNITY_END();
+}
@@ -0,0 +1,174 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Host-side counterpart of the benchmark example: replays a recorded swipe
+// through the full decode and dispatch path. Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+// Recorded report frames (register 0x01 onwards) of a swipe down:
+// GestureID, FingerNum, XposH (event in bits 6-7), XposL, YposH, YposL, pressure, area
+static const uint8_t swipe[][CST816S_REPORT_SIZE] = {
+  {0x00, 1, 0x00, 120, 0x00,  40, 0, 0},  // down
+  {0x00, 1, 0x80, 120, 0x00,  80, 0, 0},  // contact
+  {0x00, 1, 0x80, 121, 0x00, 120, 0, 0},
+  {0x00, 1, 0x80, 122, 0x00, 160, 0, 0},
+  {0x00, 1, 0x80, 122, 0x00, 200, 0, 0},
+  {0x02, 0, 0x40, 122, 0x00, 200, 0, 0},  // up, SWIPE_DOWN
+};
+
+static const size_t frame_count = sizeof(swipe) / sizeof(swipe[0]);
+static const int iterations = 60000;
+
+// Heap allocations made by the library while a test runs
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  free(p);
+}
+
+static CST816S_ReplayTransport *replay;
+static CST816S *touch;
+
+void setUp()
+{
+  replay = new CST816S_ReplayTransport(&swipe[0][0], frame_count, CST816S_REPORT_SIZE);
+  touch = new CST816S(-1, -1, *replay);  // no reset/irq pins: the replay source drives the event path
+}
+
+void tearDown()
+{
+  delete touch;
+  delete replay;
+}
+
+// Feed one recorded frame and return whether it produced an event
+static bool step()
+{
+  touch->inject_interrupt();
+  return touch->available();
+}
+
+void test_swipe_is_decoded()
+{
+  TEST_ASSERT_TRUE(step());
+  TEST_ASSERT_EQUAL(0, touch->data.event);
+  TEST_ASSERT_EQUAL(120, touch->data.x);
+  TEST_ASSERT_EQUAL(40, touch->data.y);
+
+  for (size_t i = 1; i < frame_count - 1; i++)
+  {
+    TEST_ASSERT_TRUE(step());
+    TEST_ASSERT_EQUAL(2, touch->data.event);
+  }
+
+  TEST_ASSERT_TRUE(step());
+  TEST_ASSERT_EQUAL(1, touch->data.event);
+  TEST_ASSERT_EQUAL(SWIPE_DOWN, touch->data.gestureID);
+  TEST_ASSERT_EQUAL(122, touch->data.x);
+  TEST_ASSERT_EQUAL(200, touch->data.y);
+}
+
+void test_one_read_per_interrupt()
+{
+  for (int i = 0; i < iterations; i++)
+  {
+    step();
+  }
+  TEST_ASSERT_EQUAL(iterations, replay->reads());
+  TEST_ASSERT_EQUAL(iterations, replay->frames_played());
+  TEST_ASSERT_EQUAL(0, replay->writes());
+  TEST_ASSERT_EQUAL((uint32_t)iterations * CST816S_REPORT_SIZE, replay->bytes());
+}
+
+void test_steady_state_does_not_allocate()
+{
+  for (size_t i = 0; i < frame_count; i++)
+  {
+    step();
+  }
+
+  allocations = 0;
+  for (int i = 0; i < iterations; i++)
+  {
+    step();
+  }
+  TEST_ASSERT_EQUAL(0, allocations);
+}
+
+void test_throughput()
+{
+  uint32_t worst = 0;
+  uint32_t start = cst816s_micros();
+  for (int i = 0; i < iterations; i++)
+  {
+    uint32_t t0 = cst816s_micros();
+    TEST_ASSERT_TRUE(step());
+    uint32_t dt = cst816s_micros() - t0;
+    if (dt > worst)
+    {
+      worst = dt;
+    }
+  }
+  uint32_t elapsed = cst816s_micros() - start;
+
+  char line[96];
+  snprintf(line, sizeof(line), "%lu events/s, avg %.3f us, max %lu us",
+           (unsigned long)(iterations * 1000000ULL / (elapsed ? elapsed : 1)),
+           (double)elapsed / iterations, (unsigned long)worst);
+  TEST_MESSAGE(line);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_swipe_is_decoded);
+  RUN_TEST(test_one_read_per_interrupt);
+  RUN_TEST(test_steady_state_does_not_allocate);
+  RUN_TEST(test_throughput);
+  return UNITY_END();
+}
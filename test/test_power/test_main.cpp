@@ -0,0 +1,118 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Shadow configuration across POWER_STANDBY, with a register-level fake controller.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+// Keeps a register file and counts writes per register; writes can be NACKed
+class RegisterTransport : public CST816S_Transport {
+  public:
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override
+    {
+      (void)addr;
+      for (size_t i = 0; i < length; i++)
+      {
+        data[i] = regs[(reg + i) & 0xFF];
+      }
+      return CST816S_OK;
+    }
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override
+    {
+      (void)addr;
+      if (fail_writes)
+      {
+        return CST816S_ERR_NACK;
+      }
+      for (size_t i = 0; i < length; i++)
+      {
+        regs[(reg + i) & 0xFF] = data[i];
+        writes[(reg + i) & 0xFF]++;
+      }
+      return CST816S_OK;
+    }
+
+    bool fail_writes = false;
+    uint8_t regs[256] = {};
+    uint32_t writes[256] = {};
+};
+
+static const int rst_pin = 5;
+static RegisterTransport *bus;
+static CST816S *touch;
+
+void setUp()
+{
+  bus = new RegisterTransport();
+  touch = new CST816S(rst_pin, -1, *bus);
+  touch->set_retries(0, false);
+}
+
+void tearDown()
+{
+  delete touch;
+  delete bus;
+}
+
+void test_leaving_standby_restores_configuration()
+{
+  touch->set_auto_sleep_time(7);
+  TEST_ASSERT_TRUE(touch->set_power_mode(POWER_STANDBY));
+  TEST_ASSERT_EQUAL(POWER_STANDBY, touch->power_mode());
+
+  memset(bus->writes, 0, sizeof(bus->writes));
+  bus->regs[0xF9] = 0;  // a reset restores the firmware default
+  TEST_ASSERT_TRUE(touch->set_power_mode(POWER_ACTIVE));
+  TEST_ASSERT_EQUAL(1, bus->writes[0xF9]);
+  TEST_ASSERT_EQUAL(7, bus->regs[0xF9]);
+}
+
+void test_failed_standby_keeps_the_restore()
+{
+  touch->set_auto_sleep_time(7);
+
+  // Both the standby command and its retry after the wake-up reset fail
+  bus->fail_writes = true;
+  TEST_ASSERT_FALSE(touch->set_power_mode(POWER_STANDBY));
+  TEST_ASSERT_EQUAL(POWER_ACTIVE, touch->power_mode());
+
+  bus->fail_writes = false;
+  memset(bus->writes, 0, sizeof(bus->writes));
+  bus->regs[0xF9] = 0;
+  TEST_ASSERT_TRUE(touch->set_power_mode(POWER_LOW_LATENCY));
+  TEST_ASSERT_EQUAL(1, bus->writes[0xF9]);
+  TEST_ASSERT_EQUAL(7, bus->regs[0xF9]);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_leaving_standby_restores_configuration);
+  RUN_TEST(test_failed_standby_keeps_the_restore);
+  return UNITY_END();
+}
@@ -0,0 +1,152 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// CST816S_Predictor tracking and extrapolation, driven with touch_event samples.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+#include <CST816S_Predictor.h>
+
+static CST816S_Predictor predictor;
+
+void setUp()
+{
+  predictor = CST816S_Predictor(16000);
+}
+
+void tearDown()
+{
+}
+
+static touch_event sample(uint32_t timestamp, uint8_t event, int x, int y = 50)
+{
+  touch_event e = {};
+  e.timestamp = timestamp;
+  e.points = event == 1 ? 0 : 1;
+  e.event = event;
+  e.x = x;
+  e.y = y;
+  e.point[0].event = event;
+  e.point[0].x = e.x;
+  e.point[0].y = e.y;
+  return e;
+}
+
+// Feeds a drag moving 10 px every 10 ms (1000 px/s) and returns the last sample
+static touch_event drag(int samples)
+{
+  touch_event e = sample(0, 0, 100);
+  predictor.apply(e);
+  for (int i = 1; i <= samples; i++)
+  {
+    e = sample(i * 10000, 2, 100 + i * 10);
+    predictor.apply(e);
+  }
+  return e;
+}
+
+void test_touch_down_is_passed_through()
+{
+  touch_event e = sample(1000, 0, 120, 80);
+  predictor.apply(e);
+  TEST_ASSERT_EQUAL(120, e.x);
+  TEST_ASSERT_EQUAL(80, e.y);
+}
+
+// At a steady speed the prediction settles one lead time ahead: 16 ms at
+// 1000 px/s is 16 px, while the measured point stays in point[0]
+void test_steady_drag_is_extrapolated_by_the_lead_time()
+{
+  touch_event e = drag(20);
+  int measured = 100 + 20 * 10;
+  TEST_ASSERT_EQUAL(measured, e.point[0].x);
+  TEST_ASSERT_TRUE(e.x >= measured + 14);
+  TEST_ASSERT_TRUE(e.x <= measured + 18);
+  TEST_ASSERT_EQUAL(50, e.y);
+}
+
+void test_zero_lead_only_smooths()
+{
+  predictor.set_lead_time(0);
+  touch_event e = drag(20);
+  int measured = 100 + 20 * 10;
+  TEST_ASSERT_TRUE(e.x >= measured - 2);
+  TEST_ASSERT_TRUE(e.x <= measured + 2);
+}
+
+void test_touch_up_reports_the_measured_position()
+{
+  drag(10);
+  touch_event e = sample(110000, 1, 200);
+  predictor.apply(e);
+  TEST_ASSERT_EQUAL(200, e.x);
+
+  // Contact after the release is not tracked against the old touch
+  e = sample(120000, 2, 40);
+  predictor.apply(e);
+  TEST_ASSERT_EQUAL(40, e.x);
+}
+
+// A long gap between samples restarts tracking instead of integrating
+// velocity across it; so does reset()
+void test_gap_and_reset_restart_tracking()
+{
+  drag(10);
+  touch_event e = sample(100000 + 200000, 2, 400);
+  predictor.apply(e);
+  TEST_ASSERT_EQUAL(400, e.x);
+
+  drag(10);
+  predictor.reset();
+  e = sample(110000, 2, 210);
+  predictor.apply(e);
+  TEST_ASSERT_EQUAL(210, e.x);
+}
+
+void test_prediction_is_clamped_at_the_origin()
+{
+  touch_event e = sample(0, 0, 100);
+  predictor.apply(e);
+  for (int i = 1; i <= 10; i++)
+  {
+    e = sample(i * 10000, 2, 100 - i * 10);
+    predictor.apply(e);
+  }
+  TEST_ASSERT_EQUAL(0, e.x);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_touch_down_is_passed_through);
+  RUN_TEST(test_steady_drag_is_extrapolated_by_the_lead_time);
+  RUN_TEST(test_zero_lead_only_smooths);
+  RUN_TEST(test_touch_up_reports_the_measured_position);
+  RUN_TEST(test_gap_and_reset_restart_tracking);
+  RUN_TEST(test_prediction_is_clamped_at_the_origin);
+  return UNITY_END();
+}
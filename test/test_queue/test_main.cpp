@@ -0,0 +1,128 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// CST816S_Queue and the driver's event queue overflow accounting.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_all_slots_are_usable()
+{
+  CST816S_Queue<int, 4> queue;
+  for (int i = 0; i < 4; i++)
+  {
+    TEST_ASSERT_TRUE(queue.push(i));
+  }
+  TEST_ASSERT_FALSE(queue.push(4));
+  TEST_ASSERT_EQUAL(4, queue.size());
+
+  int item = -1;
+  TEST_ASSERT_TRUE(queue.peek(item));
+  TEST_ASSERT_EQUAL(0, item);
+  for (int i = 0; i < 4; i++)
+  {
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL(i, item);
+  }
+  TEST_ASSERT_FALSE(queue.pop(item));
+  TEST_ASSERT_FALSE(queue.peek(item));
+  TEST_ASSERT_EQUAL(0, queue.size());
+}
+
+// The free-running indices wrap the storage many times over
+void test_order_is_kept_across_wraparound()
+{
+  CST816S_Queue<int, 4> queue;
+  int next = 0;
+  int expected = 0;
+  for (int round = 0; round < 100; round++)
+  {
+    TEST_ASSERT_TRUE(queue.push(next++));
+    TEST_ASSERT_TRUE(queue.push(next++));
+    TEST_ASSERT_TRUE(queue.push(next++));
+
+    int item;
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL(expected++, item);
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL(expected++, item);
+    TEST_ASSERT_TRUE(queue.pop(item));
+    TEST_ASSERT_EQUAL(expected++, item);
+  }
+  TEST_ASSERT_EQUAL(0, queue.size());
+}
+
+// Reports arriving while nothing drains the queue: the oldest are kept,
+// every report that did not fit is counted once
+void test_overflow_is_counted_in_dropped_events()
+{
+  static const uint8_t frames[][CST816S_REPORT_SIZE] = {
+    {0x00, 1, 0x00, 10, 0x00, 20, 0, 0},  // down
+    {0x00, 0, 0x40, 10, 0x00, 20, 0, 0},  // up
+  };
+  const int extra = 5;
+  CST816S_ReplayTransport replay(&frames[0][0], 2, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+
+  for (int i = 0; i < CST816S_EVENT_QUEUE_SIZE + extra; i++)
+  {
+    touch.inject_interrupt();
+    touch.service();
+  }
+  TEST_ASSERT_EQUAL_UINT32(extra, touch.dropped_events());
+
+  touch_event events[CST816S_EVENT_QUEUE_SIZE + extra];
+  size_t count = touch.read_events(events, CST816S_EVENT_QUEUE_SIZE + extra);
+  TEST_ASSERT_EQUAL_size_t(CST816S_EVENT_QUEUE_SIZE, count);
+  for (size_t i = 0; i < count; i++)
+  {
+    TEST_ASSERT_EQUAL(i % 2, events[i].event);
+  }
+
+  // Draining frees the slots again without touching the counter
+  touch.inject_interrupt();
+  touch.service();
+  TEST_ASSERT_TRUE(touch.pop_queued(events[0]));
+  TEST_ASSERT_EQUAL_UINT32(extra, touch.dropped_events());
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_all_slots_are_usable);
+  RUN_TEST(test_order_is_kept_across_wraparound);
+  RUN_TEST(test_overflow_is_counted_in_dropped_events);
+  return UNITY_END();
+}
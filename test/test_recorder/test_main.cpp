@@ -0,0 +1,183 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// CST816S_Recorder stream format and a record/replay round trip through the driver.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+#include <CST816S_Recorder.h>
+
+static const uint8_t frames[][CST816S_REPORT_SIZE] = {
+  {0x00, 1, 0x00, 20, 0x00, 200, 0, 0},   // down
+  {0x00, 1, 0x80, 60, 0x00, 200, 0, 0},   // contact
+  {0x00, 1, 0x80, 110, 0x00, 200, 0, 0},  // contact
+  {0x00, 0, 0x40, 110, 0x00, 200, 0, 0},  // up
+};
+
+static uint8_t storage[256];
+
+void setUp()
+{
+  memset(storage, 0, sizeof(storage));
+}
+
+void tearDown()
+{
+}
+
+void test_stream_has_header_and_varint_deltas()
+{
+  static const uint8_t frame[4] = {1, 2, 3, 4};
+  CST816S_Recorder recorder(storage, sizeof(storage), sizeof(frame));
+  recorder.record(0, frame, sizeof(frame));  // not recording yet
+  recorder.start();
+  recorder.record(1000, frame, sizeof(frame));
+  recorder.record(1300, frame, sizeof(frame));
+  recorder.record(1300, frame, 3);  // wrong frame size
+  TEST_ASSERT_EQUAL_UINT32(2, recorder.frames());
+
+  uint8_t out[32];
+  size_t n = recorder.flush(out, sizeof(out));
+  TEST_ASSERT_EQUAL_size_t(CST816S_RECORD_HEADER_SIZE + 1 + 4 + 2 + 4, n);
+  TEST_ASSERT_EQUAL('C', out[0]);
+  TEST_ASSERT_EQUAL('S', out[1]);
+  TEST_ASSERT_EQUAL(CST816S_RECORD_VERSION, out[2]);
+  TEST_ASSERT_EQUAL(4, out[3]);
+  TEST_ASSERT_EQUAL(0, out[4]);              // first record starts the clock
+  TEST_ASSERT_EQUAL(1, out[5]);
+  TEST_ASSERT_EQUAL(0x80 | (300 & 0x7F), out[9]);  // 300 us as LEB128
+  TEST_ASSERT_EQUAL(300 >> 7, out[10]);
+  TEST_ASSERT_EQUAL(0, recorder.pending());
+}
+
+// A destination smaller than the buffered data takes the rest on the next call
+void test_short_flush_keeps_the_rest()
+{
+  static const uint8_t frame[4] = {9, 8, 7, 6};
+  CST816S_Recorder recorder(storage, sizeof(storage), sizeof(frame));
+  recorder.start();
+  recorder.record(0, frame, sizeof(frame));
+
+  uint8_t out[16];
+  TEST_ASSERT_EQUAL_size_t(0, recorder.flush(out, 2));  // too small for the header
+  TEST_ASSERT_EQUAL_size_t(CST816S_RECORD_HEADER_SIZE + 2, recorder.flush(out, 6));
+  TEST_ASSERT_EQUAL_size_t(3, recorder.pending());
+  TEST_ASSERT_EQUAL_size_t(3, recorder.flush(out, sizeof(out)));
+  TEST_ASSERT_EQUAL(8, out[0]);
+  TEST_ASSERT_EQUAL(6, out[2]);
+}
+
+void test_full_buffer_drops_or_overwrites()
+{
+  static const uint8_t frame[4] = {1, 2, 3, 4};
+  uint8_t small[16];
+  CST816S_Recorder recorder(small, sizeof(small), sizeof(frame));
+  recorder.start();
+  for (int i = 0; i < 4; i++)
+  {
+    recorder.record(i * 10, frame, sizeof(frame));
+  }
+  // 5 bytes per record, 15 usable bytes
+  TEST_ASSERT_EQUAL_UINT32(3, recorder.frames());
+  TEST_ASSERT_EQUAL_UINT32(1, recorder.dropped());
+
+  recorder.clear();
+  recorder.set_overwrite(true);
+  recorder.start();
+  for (int i = 0; i < 5; i++)
+  {
+    recorder.record(i * 10, frame, sizeof(frame));
+  }
+  TEST_ASSERT_EQUAL_UINT32(5, recorder.frames());
+  TEST_ASSERT_EQUAL_UINT32(2, recorder.dropped());
+  TEST_ASSERT_EQUAL_size_t(15, recorder.pending());
+}
+
+// Reports recorded from the driver replay into the same events
+void test_recording_replays_through_the_driver()
+{
+  CST816S_Recorder recorder(storage, sizeof(storage));
+  CST816S_ReplayTransport replay(&frames[0][0], 4, CST816S_REPORT_SIZE);
+  CST816S live(-1, -1, replay);
+  live.set_recorder(&recorder);
+  recorder.start();
+
+  data_struct expected[4];
+  for (int i = 0; i < 4; i++)
+  {
+    live.inject_interrupt();
+    TEST_ASSERT_TRUE(live.available());
+    expected[i] = live.data;
+  }
+  recorder.stop();
+  TEST_ASSERT_EQUAL_UINT32(4, recorder.frames());
+
+  uint8_t stream[128];
+  size_t length = recorder.flush(stream, sizeof(stream));
+  TEST_ASSERT_EQUAL_size_t(CST816S_RECORD_HEADER_SIZE + 4 * (1 + CST816S_REPORT_SIZE), length);
+
+  CST816S_Player player(stream, length);
+  TEST_ASSERT_TRUE(player.valid());
+  player.set_realtime(false);
+  CST816S touch(-1, -1, player);
+
+  for (int i = 0; i < 4; i++)
+  {
+    TEST_ASSERT_TRUE(player.update(touch));
+    TEST_ASSERT_TRUE(touch.available());
+    TEST_ASSERT_EQUAL(expected[i].event, touch.data.event);
+    TEST_ASSERT_EQUAL(expected[i].x, touch.data.x);
+    TEST_ASSERT_EQUAL(expected[i].y, touch.data.y);
+    TEST_ASSERT_EQUAL(expected[i].gestureID, touch.data.gestureID);
+  }
+  TEST_ASSERT_TRUE(player.finished());
+  TEST_ASSERT_FALSE(player.update(touch));
+  TEST_ASSERT_EQUAL_UINT32(4, player.frames_played());
+
+  player.rewind();
+  TEST_ASSERT_FALSE(player.finished());
+  TEST_ASSERT_EQUAL_UINT32(0, player.frames_played());
+}
+
+void test_stream_without_header_is_rejected()
+{
+  static const uint8_t bad[] = {'C', 'S', CST816S_RECORD_VERSION + 1, CST816S_REPORT_SIZE};
+  CST816S_Player player(bad, sizeof(bad));
+  TEST_ASSERT_FALSE(player.valid());
+  TEST_ASSERT_TRUE(player.finished());
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_stream_has_header_and_varint_deltas);
+  RUN_TEST(test_short_flush_keeps_the_rest);
+  RUN_TEST(test_full_buffer_drops_or_overwrites);
+  RUN_TEST(test_recording_replays_through_the_driver);
+  RUN_TEST(test_stream_without_header_is_rejected);
+  return UNITY_END();
+}
@@ -0,0 +1,224 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Transfer retries and bus recovery, driven by a transport that fails on demand.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+static const uint8_t frames[][CST816S_REPORT_SIZE] = {
+  {0x00, 1, 0x00, 120, 0x00, 40, 0, 0},  // down
+  {0x00, 1, 0x80, 120, 0x00, 80, 0, 0},  // contact
+};
+
+// Replays the frames above, failing the next `fail` transfers or all of them
+class FaultyTransport : public CST816S_Transport {
+  public:
+    uint8_t read(uint8_t addr, uint8_t reg, uint8_t *data, size_t length) override
+    {
+      reads++;
+      if (fault())
+      {
+        memset(data, 0, length);
+        return CST816S_ERR_NACK;
+      }
+      return _replay.read(addr, reg, data, length);
+    }
+    uint8_t write(uint8_t addr, uint8_t reg, const uint8_t *data, size_t length) override
+    {
+      writes++;
+      return fault() ? (uint8_t)CST816S_ERR_NACK : _replay.write(addr, reg, data, length);
+    }
+    bool recover() override
+    {
+      recovers++;
+      return true;
+    }
+
+    uint32_t fail = 0;
+    bool dead = false;
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+    uint32_t recovers = 0;
+
+  private:
+    CST816S_ReplayTransport _replay{&frames[0][0], 2, CST816S_REPORT_SIZE};
+
+    bool fault()
+    {
+      if (dead)
+      {
+        return true;
+      }
+      if (fail)
+      {
+        fail--;
+        return true;
+      }
+      return false;
+    }
+};
+
+static const int rst_pin = 5;
+static FaultyTransport *bus;
+static CST816S *touch;
+
+void setUp()
+{
+  bus = new FaultyTransport();
+  touch = new CST816S(rst_pin, -1, *bus);
+  cst816s_digital_write(rst_pin, CST816S_HIGH);
+}
+
+void tearDown()
+{
+  delete touch;
+  delete bus;
+}
+
+// Run service() until the deferred reset has finished, return the longest call in us
+static uint32_t run_reset(uint32_t ms)
+{
+  uint32_t worst = 0;
+  uint32_t start = cst816s_millis();
+  while (cst816s_millis() - start < ms)
+  {
+    uint32_t t0 = cst816s_micros();
+    touch->service();
+    uint32_t dt = cst816s_micros() - t0;
+    if (dt > worst)
+    {
+      worst = dt;
+    }
+    cst816s_delay_us(200);
+  }
+  return worst;
+}
+
+void test_retry_succeeds_without_recovery()
+{
+  bus->fail = CST816S_I2C_RETRIES;
+  touch->inject_interrupt();
+  TEST_ASSERT_TRUE(touch->available());
+
+  i2c_health health = touch->health();
+  TEST_ASSERT_EQUAL(CST816S_I2C_RETRIES, health.retries);
+  TEST_ASSERT_EQUAL(0, health.recoveries);
+  TEST_ASSERT_EQUAL(0, health.errors);
+  TEST_ASSERT_EQUAL(CST816S_I2C_RETRIES + 1, bus->reads);
+  TEST_ASSERT_EQUAL(0, bus->recovers);
+}
+
+void test_recovery_resets_the_controller_from_service()
+{
+  touch->set_auto_sleep_time(5);
+  uint32_t writes = bus->writes;
+
+  // All retries fail, the attempt after the bus recovery succeeds
+  bus->fail = CST816S_I2C_RETRIES + 1;
+  touch->inject_interrupt();
+  uint32_t t0 = cst816s_micros();
+  TEST_ASSERT_TRUE(touch->available());
+  TEST_ASSERT_TRUE(cst816s_micros() - t0 < 5000);
+  TEST_ASSERT_EQUAL(1, touch->health().recoveries);
+  TEST_ASSERT_EQUAL(1, bus->recovers);
+
+  // The reset and configuration restore were left to the next service()
+  TEST_ASSERT_EQUAL(writes, bus->writes);
+  TEST_ASSERT_EQUAL(CST816S_HIGH, cst816s_digital_read(rst_pin));
+  touch->service();
+  TEST_ASSERT_EQUAL(CST816S_LOW, cst816s_digital_read(rst_pin));
+
+  TEST_ASSERT_TRUE(run_reset(CST816S_RESET_PULSE_MS + 10) < 5000);
+  TEST_ASSERT_EQUAL(CST816S_HIGH, cst816s_digital_read(rst_pin));
+  TEST_ASSERT_TRUE(bus->writes > writes);
+
+  // Reports are read again once the controller is back
+  touch->inject_interrupt();
+  TEST_ASSERT_TRUE(touch->available());
+}
+
+void test_dead_controller_never_blocks()
+{
+  bus->dead = true;
+  uint32_t worst = 0;
+  uint32_t start = cst816s_millis();
+  while (cst816s_millis() - start < 3 * CST816S_RECOVERY_INTERVAL_MS)
+  {
+    touch->inject_interrupt();
+    uint32_t t0 = cst816s_micros();
+    TEST_ASSERT_FALSE(touch->available());
+    uint32_t dt = cst816s_micros() - t0;
+    if (dt > worst)
+    {
+      worst = dt;
+    }
+    cst816s_delay(1);
+  }
+
+  i2c_health health = touch->health();
+  TEST_ASSERT_TRUE(worst < 5000);
+  TEST_ASSERT_TRUE(health.errors > 0);
+  TEST_ASSERT_EQUAL(CST816S_ERR_NACK, health.last_error);
+  // Rate limited to one recovery per interval
+  TEST_ASSERT_TRUE(health.recoveries >= 1);
+  TEST_ASSERT_TRUE(health.recoveries <= 4);
+}
+
+void test_sleep_with_dead_controller_is_bounded()
+{
+  bus->dead = true;
+  uint32_t start = cst816s_millis();
+  TEST_ASSERT_FALSE(touch->set_power_mode(POWER_STANDBY));
+  // Reset pulse and the 50 ms wake-up wait, no recovery inline
+  TEST_ASSERT_TRUE(cst816s_millis() - start < CST816S_RESET_PULSE_MS + 50 + 10);
+}
+
+void test_recovery_can_be_disabled()
+{
+  touch->set_retries(1, false);
+  bus->dead = true;
+  touch->inject_interrupt();
+  TEST_ASSERT_FALSE(touch->available());
+
+  i2c_health health = touch->health();
+  TEST_ASSERT_EQUAL(1, health.retries);
+  TEST_ASSERT_EQUAL(0, health.recoveries);
+  TEST_ASSERT_EQUAL(1, health.errors);
+  TEST_ASSERT_EQUAL(2, bus->reads);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_retry_succeeds_without_recovery);
+  RUN_TEST(test_recovery_resets_the_controller_from_service);
+  RUN_TEST(test_dead_controller_never_blocks);
+  RUN_TEST(test_sleep_with_dead_controller_is_bounded);
+  RUN_TEST(test_recovery_can_be_disabled);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Report validation on every chip profile, driven through ReplayTransport.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+static const CHIP_VARIANT variants[] = {
+  CHIP_UNKNOWN, CHIP_CST816S, CHIP_CST816T, CHIP_CST816D, CHIP_CST820, CHIP_CST716,
+};
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Play one frame on a chip profile and return whether it produced an event
+static bool play(CHIP_VARIANT variant, const uint8_t *frame, i2c_health &health)
+{
+  CST816S_ReplayTransport replay(frame, 1, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+  touch.set_chip(variant);
+  touch.inject_interrupt();
+  bool delivered = touch.available();
+  health = touch.health();
+  return delivered;
+}
+
+void test_all_ff_frame_is_rejected()
+{
+  uint8_t frame[CST816S_REPORT_SIZE];
+  memset(frame, 0xFF, sizeof(frame));
+
+  for (CHIP_VARIANT variant : variants)
+  {
+    i2c_health health;
+    TEST_ASSERT_FALSE(play(variant, frame, health));
+    TEST_ASSERT_EQUAL(1, health.bad_frames);
+    TEST_ASSERT_EQUAL(CST816S_ERR_BAD_FRAME, health.last_error);
+  }
+}
+
+void test_reserved_event_code_is_rejected()
+{
+  const uint8_t frame[CST816S_REPORT_SIZE] = {0x00, 1, 0xC0, 120, 0x00, 40, 0, 0};
+
+  for (CHIP_VARIANT variant : variants)
+  {
+    i2c_health health;
+    TEST_ASSERT_FALSE(play(variant, frame, health));
+    TEST_ASSERT_EQUAL(1, health.bad_frames);
+  }
+}
+
+void test_valid_frame_is_accepted()
+{
+  const uint8_t frame[CST816S_REPORT_SIZE] = {0x00, 1, 0x00, 120, 0x00, 40, 0, 0};
+
+  for (CHIP_VARIANT variant : variants)
+  {
+    i2c_health health;
+    TEST_ASSERT_TRUE(play(variant, frame, health));
+    TEST_ASSERT_EQUAL(0, health.bad_frames);
+  }
+}
+
+// The CST716 has no gesture register, any GestureID value is accepted
+void test_cst716_ignores_gesture_byte()
+{
+  const uint8_t frame[CST816S_REPORT_SIZE] = {0x7F, 1, 0x00, 120, 0x00, 40, 0, 0};
+  i2c_health health;
+
+  TEST_ASSERT_TRUE(play(CHIP_CST716, frame, health));
+  TEST_ASSERT_FALSE(play(CHIP_CST816S, frame, health));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_all_ff_frame_is_rejected);
+  RUN_TEST(test_reserved_event_code_is_rejected);
+  RUN_TEST(test_valid_frame_is_accepted);
+  RUN_TEST(test_cst716_ignores_gesture_byte);
+  return UNITY_END();
+}
@@ -0,0 +1,10 @@
+// Telemetry is opt-in: without the build flag the header compiles it out.
+// Only macros are checked here; nothing from this file is linked against.
+
+#undef CST816S_TELEMETRY
+#include <CST816S.h>
+
+static_assert(CST816S_TELEMETRY == 0, "telemetry must default to off");
+#ifdef CST816S_TELEMETRY_SIZE
+#error "telemetry types must not be declared without CST816S_TELEMETRY"
+#endif
@@ -0,0 +1,152 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Telemetry counters: one count per report read and the packed export.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+
+static const uint8_t swipe[][CST816S_REPORT_SIZE] = {
+  {0x00, 1, 0x00, 200, 0x00, 100, 0, 0},  // down
+  {0x03, 1, 0x80, 150, 0x00, 100, 0, 0},  // contact, SWIPE_LEFT
+  {0x03, 1, 0x80, 100, 0x00, 100, 0, 0},  // contact, GestureID repeated
+  {0x03, 0, 0x40, 60, 0x00, 100, 0, 0},   // up, still SWIPE_LEFT
+};
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static uint32_t sum(const uint32_t *counts, int n)
+{
+  uint32_t total = 0;
+  for (int i = 0; i < n; i++)
+  {
+    total += counts[i];
+  }
+  return total;
+}
+
+// The controller repeats GestureID until the finger lifts: one gesture, one touch
+void test_touch_and_gesture_are_counted_once()
+{
+  CST816S_ReplayTransport replay(&swipe[0][0], 4, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+
+  for (int i = 0; i < 4; i++)
+  {
+    touch.inject_interrupt();
+    TEST_ASSERT_TRUE(touch.available());
+  }
+
+  touch_telemetry t = touch.telemetry();
+  TEST_ASSERT_EQUAL_UINT32(1, t.touches);
+  TEST_ASSERT_EQUAL_UINT32(1, t.gestures[SWIPE_LEFT - SWIPE_UP]);
+  TEST_ASSERT_EQUAL_UINT32(1, sum(t.gestures, CST816S_TELEMETRY_GESTURES));
+  TEST_ASSERT_EQUAL_UINT32(1, sum(t.durations, CST816S_DURATION_BUCKETS));
+}
+
+// read_async() re-reads the registers; those reads are not counted again
+void test_async_reads_are_not_counted()
+{
+  CST816S_ReplayTransport replay(&swipe[0][0], 4, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+
+  for (int i = 0; i < 8; i++)
+  {
+    TEST_ASSERT_TRUE(touch.read_async());
+    touch_event event;
+    TEST_ASSERT_TRUE(touch.read_async_done(event));
+  }
+
+  touch_telemetry t = touch.telemetry();
+  TEST_ASSERT_EQUAL_UINT32(0, t.touches);
+  TEST_ASSERT_EQUAL_UINT32(0, sum(t.gestures, CST816S_TELEMETRY_GESTURES));
+  TEST_ASSERT_EQUAL_UINT32(0, sum(t.durations, CST816S_DURATION_BUCKETS));
+}
+
+void test_long_touch_lands_in_a_later_bucket()
+{
+  CST816S_ReplayTransport replay(&swipe[0][0], 4, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+
+  touch.inject_interrupt();
+  TEST_ASSERT_TRUE(touch.available());
+  cst816s_delay(60);
+  for (int i = 1; i < 4; i++)
+  {
+    touch.inject_interrupt();
+    TEST_ASSERT_TRUE(touch.available());
+  }
+
+  touch_telemetry t = touch.telemetry();
+  TEST_ASSERT_EQUAL_UINT32(0, t.durations[0]);  // < 50 ms
+  TEST_ASSERT_EQUAL_UINT32(1, sum(t.durations, CST816S_DURATION_BUCKETS));
+}
+
+void test_pack_writes_header_and_varints()
+{
+  CST816S_ReplayTransport replay(&swipe[0][0], 4, CST816S_REPORT_SIZE);
+  CST816S touch(-1, -1, replay);
+  for (int i = 0; i < 4; i++)
+  {
+    touch.inject_interrupt();
+    TEST_ASSERT_TRUE(touch.available());
+  }
+
+  uint8_t buffer[CST816S_TELEMETRY_SIZE];
+  size_t length = touch.telemetry_pack(buffer, sizeof(buffer));
+  TEST_ASSERT_TRUE(length >= 3 + CST816S_TELEMETRY_FIELDS);
+  TEST_ASSERT_EQUAL('C', buffer[0]);
+  TEST_ASSERT_EQUAL('T', buffer[1]);
+  TEST_ASSERT_EQUAL(1, buffer[2]);
+
+  // Skip the uptime varint; the touch count follows it
+  size_t pos = 3;
+  while (buffer[pos] & 0x80)
+  {
+    pos++;
+  }
+  TEST_ASSERT_EQUAL(1, buffer[pos + 1]);
+
+  TEST_ASSERT_EQUAL_size_t(0, touch.telemetry_pack(buffer, 2));
+  TEST_ASSERT_EQUAL_size_t(0, touch.telemetry_pack(buffer, 3 + CST816S_TELEMETRY_FIELDS - 1));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_touch_and_gesture_are_counted_once);
+  RUN_TEST(test_async_reads_are_not_counted);
+  RUN_TEST(test_long_touch_lands_in_a_later_bucket);
+  RUN_TEST(test_pack_writes_header_and_varints);
+  return UNITY_END();
+}
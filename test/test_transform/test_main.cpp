@@ -0,0 +1,118 @@
+/*
+   MIT License
+
+  Copyright (c) 2021 Felix Biego
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// CST816S_Transform rotation, mirroring, scaling and calibration order.
+// Run with `pio test -e native`.
+
+#include <unity.h>
+#include <CST816S.h>
+#include <CST816S_Transform.h>
+
+static CST816S_Transform transform;
+
+void setUp()
+{
+  transform.reset();
+}
+
+void tearDown()
+{
+}
+
+static void assert_maps(int x, int y, int expected_x, int expected_y)
+{
+  transform.map(x, y);
+  TEST_ASSERT_EQUAL(expected_x, x);
+  TEST_ASSERT_EQUAL(expected_y, y);
+}
+
+void test_mirror_without_panel_size_is_ignored()
+{
+  transform.set_mirror(true, true);
+  assert_maps(10, 20, 10, 20);
+
+  // Applied as soon as the panel size is known
+  transform.set_rotation(0, 240, 280);
+  assert_maps(10, 20, 229, 259);
+}
+
+void test_rotation()
+{
+  transform.set_rotation(1, 240, 280);
+  assert_maps(10, 20, 259, 10);
+  transform.set_rotation(2, 240, 280);
+  assert_maps(10, 20, 229, 259);
+  transform.set_rotation(3, 240, 280);
+  assert_maps(10, 20, 20, 229);
+}
+
+void test_screen_scaling()
+{
+  transform.set_rotation(0, 240, 280);
+  transform.set_screen(480, 560);
+  assert_maps(0, 0, 0, 0);
+  assert_maps(120, 140, 240, 280);
+}
+
+// Touch (x, y) lands on screen (2 x + 5, y / 2 + 10)
+static const int touch_x[] = {0, 200, 0, 200};
+static const int touch_y[] = {0, 0, 200, 200};
+static const int screen_x[] = {5, 405, 5, 405};
+static const int screen_y[] = {10, 10, 110, 110};
+
+void test_calibration_last_is_kept()
+{
+  transform.set_rotation(1, 240, 280);
+  TEST_ASSERT_TRUE(transform.calibrate(touch_x, touch_y, screen_x, screen_y, 4));
+  assert_maps(100, 100, 205, 60);
+}
+
+void test_setters_after_calibration_replace_it()
+{
+  TEST_ASSERT_TRUE(transform.calibrate(touch_x, touch_y, screen_x, screen_y, 4));
+  transform.set_rotation(0, 240, 280);
+  transform.set_screen(240, 280);
+  assert_maps(100, 100, 100, 100);
+}
+
+void test_collinear_calibration_is_rejected()
+{
+  const int line[] = {0, 100, 200};
+  TEST_ASSERT_FALSE(transform.calibrate(line, line, line, line, 3));
+  assert_maps(100, 100, 100, 100);
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_mirror_without_panel_size_is_ignored);
+  RUN_TEST(test_rotation);
+  RUN_TEST(test_screen_scaling);
+  RUN_TEST(test_calibration_last_is_kept);
+  RUN_TEST(test_setters_after_calibration_replace_it);
+  RUN_TEST(test_collinear_calibration_is_rejected);
+  return UNITY_END();
+}